@@ -0,0 +1,3 @@
+--- The unit price computed from the calculation parts, NULL if outdated
+
+ALTER TABLE Catalog ADD COLUMN calcPrice DECIMAL(10,2);
@@ -232,6 +232,7 @@ void ArchDoc::loadItems( const QString& archDocId )
 
   if ( archDocId.isEmpty() /* || ! archDocId.isNum() */ ) {
     // qDebug () << "ArchDocId is not crappy: " << archDocId << endl;
+    mPositions.setTaxes(mTax, mReducedTax);
     return;
   }
 
@@ -243,8 +244,6 @@ void ArchDoc::loadItems( const QString& archDocId )
       qDebug() << "Error: " << q.lastError().nativeErrorCode();
   }
 
-  mPositions.setTaxes(mTax, mReducedTax);
-
   while( q.next() ) {
     ArchDocPosition pos;
     pos.mPosNo = q.value( 2 ).toString();
@@ -265,6 +264,8 @@ void ArchDoc::loadItems( const QString& archDocId )
 
     mPositions.append( pos );
   }
+  // sums up the positions
+  mPositions.setTaxes(mTax, mReducedTax);
 }
 
 QList<ArchDocPosition> ArchDoc::itemslist() const
@@ -115,21 +115,16 @@ QString ArchDocPosition::unitEC20() const
 // ==================================================================
 
 ArchDocPositionList::ArchDocPositionList()
-    : QList<ArchDocPosition>()
+    : QList<ArchDocPosition>(),
+      _fullTax(0.0),
+      _reducedTax(0.0)
 {
 
 }
 
 Geld ArchDocPositionList::sumPrice() const
 {
-    Geld g;
-
-    const_iterator it;
-    for ( it = begin(); it != end(); ++it ) {
-      g += ( *it ).nettoPrice();
-    }
-
-    return g;
+    return totals().netto();
 }
 
 Geld ArchDocPositionList::taxSum() const
@@ -141,55 +136,29 @@ Geld ArchDocPositionList::taxSum() const
 
 Geld ArchDocPositionList::fullTaxSum() const
 {
-    Geld g;
-    const_iterator it;
-    for ( it = begin(); it != end(); ++it ) {
-        if( (*it).taxType() == DocPositionBase::TaxFull) {
-            g += (*it).nettoPrice();
-        }
-    }
+    // other than for the document, a negative base results in a negative tax
+    Geld g = totals().fullTaxBase();
     const Geld ftSum(g.percent(_fullTax).toLong());
     return ftSum;
 }
 
 Geld ArchDocPositionList::reducedTaxSum() const
 {
-    Geld g;
-    const_iterator it;
-    for ( it = begin(); it != end(); ++it ) {
-        if( (*it).taxType() == DocPositionBase::TaxReduced) {
-            g += (*it).nettoPrice();
-        }
-    }
+    Geld g = totals().reducedTaxBase();
     const Geld rtSum(g.percent(_reducedTax).toLong());
     return rtSum;
 }
 
 DocPositionBase::TaxType ArchDocPositionList::listTaxation() const
 {
-    int fullTax = 0;
-    int noTax = 0;
-    int redTax = 0;
-
     DocPositionBase::TaxType ret = DocPositionBase::TaxType::TaxNone;
 
-    const_iterator it;
-    for ( it = begin(); it != end(); ++it ) {
-        if( (*it).taxType() == DocPositionBase::TaxFull) {
-            fullTax++;
-        } else if( (*it).taxType() == DocPositionBase::TaxReduced ) {
-            redTax++;
-        } else if( (*it).taxType() == DocPositionBase::TaxNone ) {
-            noTax++;
-        }
-    }
-
-    int cnt = count();
-    if (noTax == cnt) {
+    const int cnt = totals().count();
+    if (totals().count(DocPositionBase::TaxNone) == cnt) {
         ret = DocPositionBase::TaxType::TaxNone;
-    } else if (redTax == cnt) {
+    } else if (totals().count(DocPositionBase::TaxReduced) == cnt) {
         ret = DocPositionBase::TaxType::TaxReduced;
-    } else if (fullTax == cnt) {
+    } else if (totals().count(DocPositionBase::TaxFull) == cnt) {
         ret = DocPositionBase::TaxType::TaxFull;
     } else
         ret = DocPositionBase::TaxType::TaxIndividual;
@@ -208,3 +177,20 @@ void ArchDocPositionList::setTaxes(double fullTax, double reducedTax)
     _fullTax = fullTax;
     _reducedTax = reducedTax;
 }
+
+const DocTotals& ArchDocPositionList::totals() const
+{
+    // any modification detaches the list from the copy
+    if (_totalsPositions.size() == size() && _totalsPositions.constBegin() == constBegin()) {
+        return _totals;
+    }
+
+    DocTotals totals;
+    const_iterator it;
+    for ( it = constBegin(); it != constEnd(); ++it ) {
+        totals.addPosition((*it).nettoPrice(), (*it).taxType());
+    }
+    _totals = totals;
+    _totalsPositions = *this;
+    return _totals;
+}
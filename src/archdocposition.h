@@ -93,9 +93,18 @@ class ArchDocPositionList : public QList<ArchDocPosition>
 
     void setTaxes(double fullTax, double reducedTax);
 
+    /**
+     * The sums of all positions, computed in one pass on first access and
+     * again after the list was modified.
+     */
+    const DocTotals& totals() const;
+
 private:
     double _fullTax;
     double _reducedTax;
+    mutable DocTotals _totals;
+    // shares the data with the list as long as the list is not modified
+    mutable QList<ArchDocPosition> _totalsPositions;
 };
 
 Q_DECLARE_METATYPE(ArchDocPosition)
@@ -0,0 +1,275 @@
+/***************************************************************************
+           batchrenderer.cpp - render archived documents headless
+                             -------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by Klaas Freitag
+    email                : kraft@freisturz.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QDir>
+#include <QFile>
+#include <QSqlQuery>
+#include <QStandardPaths>
+#include <QThread>
+#include <QTimer>
+#include <QDebug>
+
+#include <KLocalizedString>
+#include <kcontacts/vcardconverter.h>
+
+#include "batchrenderer.h"
+#include "reportgenerator.h"
+#include "kraftdb.h"
+#include "databasesettings.h"
+#include "addressprovider.h"
+#include "rendertrace.h"
+
+BatchRenderer::BatchRenderer(QObject *parent)
+    : QObject(parent),
+      _maxJobs(QThread::idealThreadCount()),
+      _jobTimeout(300),
+      _total(0),
+      _succeeded(0),
+      _finished(false)
+{
+
+}
+
+void BatchRenderer::setDateRange(const QDate& from, const QDate& to)
+{
+    _from = from;
+    _to = to;
+}
+
+void BatchRenderer::setOutputDir(const QString& dir)
+{
+    _outputDir = dir;
+}
+
+void BatchRenderer::setMaxJobs(int jobs)
+{
+    _maxJobs = qMax(1, jobs);
+}
+
+void BatchRenderer::setJobTimeout(int secs)
+{
+    _jobTimeout = qMax(0, secs);
+}
+
+void BatchRenderer::setTraceFile(const QString& file)
+{
+    _traceFile = file;
+}
+
+void BatchRenderer::start()
+{
+    if (!_from.isValid() || !_to.isValid() || _from > _to) {
+        _setupError = i18n("Invalid date range.");
+        finish(SetupFailed);
+        return;
+    }
+
+    if (!_outputDir.isEmpty()) {
+        QDir dir;
+        if (!dir.mkpath(_outputDir)) {
+            _setupError = i18n("The output directory %1 can not be created.", _outputDir);
+            finish(SetupFailed);
+            return;
+        }
+    }
+
+    if (!connectDatabase(&_setupError)) {
+        finish(SetupFailed);
+        return;
+    }
+
+    _myContact = myIdentity();
+    _queue = archivedDocuments();
+    _total = _queue.size();
+
+    qDebug() << "Rendering" << _total << "archived documents with" << _maxJobs << "parallel jobs";
+
+    if (_queue.isEmpty()) {
+        finish(Success);
+        return;
+    }
+    startNextJobs();
+}
+
+bool BatchRenderer::connectDatabase(QString *error)
+{
+    const QString dbDriver = DatabaseSettings::self()->dbDriver().toUpper();
+    QString dbName = DatabaseSettings::self()->dbDatabaseName();
+    if( dbDriver == QLatin1String("QSQLITE")) {
+        dbName = DatabaseSettings::self()->dbFile();
+    }
+
+    if (!KraftDB::self()->dbConnect(dbDriver, dbName,
+                                    DatabaseSettings::self()->dbUser(),
+                                    DatabaseSettings::self()->dbServerName(),
+                                    DatabaseSettings::self()->dbPassword())) {
+        *error = i18n("The database can not be connected: %1", KraftDB::self()->lastError().text());
+        return false;
+    }
+
+    if (!KraftDB::self()->databaseExists()) {
+        *error = i18n("The database does not contain valid content.");
+        return false;
+    }
+
+    // Schema updates need the setup assistant, which is not available headless.
+    if (KraftDB::self()->currentSchemaVersion() != KraftDB::self()->requiredSchemaVersion()) {
+        *error = i18n("The database schema version does not match. Start Kraft interactively to update it.");
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Only the manually entered identity is used here, as a lookup in the
+ * address book would require Akonadi.
+ */
+KContacts::Addressee BatchRenderer::myIdentity() const
+{
+    KContacts::Addressee contact;
+
+    QString file = QStandardPaths::writableLocation( QStandardPaths::AppDataLocation );
+    file += "/myidentity.vcd";
+    QFile f(file);
+    if( f.open( QIODevice::ReadOnly )) {
+        const QByteArray data = f.readAll();
+        KContacts::VCardConverter converter;
+        KContacts::Addressee::List list = converter.parseVCards( data );
+
+        if( list.count() > 0 ) {
+            contact = list.at(0);
+            contact.insertCustom(CUSTOM_ADDRESS_MARKER, "manual");
+        }
+    } else {
+        qDebug() << "No identity file found at" << file;
+    }
+    return contact;
+}
+
+/*
+ * Returns the latest archived version of every document dated within
+ * the range.
+ */
+QList<ArchDocDigest> BatchRenderer::archivedDocuments() const
+{
+    QSqlQuery q;
+    q.prepare("SELECT archDocID, ident, docType, printDate, state FROM archdoc WHERE "
+              "date BETWEEN :from AND :to ORDER BY ident, printDate");
+    q.bindValue(":from", _from.toString("yyyy-MM-dd"));
+    q.bindValue(":to", _to.toString("yyyy-MM-dd"));
+    q.exec();
+
+    QMap<QString, ArchDocDigest> latest;
+    while (q.next()) {
+        const QString ident = q.value(1).toString();
+        latest[ident] = ArchDocDigest(q.value(3).toDateTime(), q.value(4).toInt(),
+                                      ident, q.value(2).toString(), dbID(q.value(0).toInt()));
+    }
+    return latest.values();
+}
+
+void BatchRenderer::startNextJobs()
+{
+    while (_running.size() < _maxJobs && !_queue.isEmpty()) {
+        const ArchDocDigest digest = _queue.takeFirst();
+
+        ReportGenerator *generator = new ReportGenerator;
+        generator->setCustomerLookup(false);
+        generator->setOutputDir(_outputDir);
+        generator->setMyContact(_myContact);
+
+        connect(generator, &ReportGenerator::docAvailable, this,
+                [this, generator](ReportFormat, const QString&, const KContacts::Addressee&) {
+            jobDone(generator, QString());
+        });
+        connect(generator, &ReportGenerator::failure, this,
+                [this, generator](const QString& err) {
+            jobDone(generator, err);
+        });
+
+        if (_jobTimeout > 0) {
+            // deleted together with the generator
+            QTimer *timer = new QTimer(generator);
+            timer->setSingleShot(true);
+            connect(timer, &QTimer::timeout, this, [this, generator]() {
+                jobDone(generator, i18n("The document was not rendered within %1 seconds.", _jobTimeout));
+            });
+            timer->start(_jobTimeout * 1000);
+        }
+
+        _running.insert(generator, digest.archDocIdent());
+        qDebug() << "Rendering" << digest.archDocIdent();
+        generator->createDocument(ReportFormat::PDF, digest.archDocIdent(), digest.archDocId());
+    }
+
+    if (_running.isEmpty() && _queue.isEmpty()) {
+        finish(_failures.isEmpty() ? Success : DocumentsFailed);
+    }
+}
+
+void BatchRenderer::jobDone(ReportGenerator *generator, const QString& error)
+{
+    // a generator might report more than one failure, count it only once
+    if (!_running.contains(generator)) {
+        return;
+    }
+    const QString ident = _running.take(generator);
+
+    if (error.isEmpty()) {
+        _succeeded++;
+    } else {
+        _failures[ident] = error;
+    }
+    generator->deleteLater();
+
+    // failures can be reported from within createDocument, so do not recurse.
+    QTimer::singleShot(0, this, &BatchRenderer::startNextJobs);
+}
+
+void BatchRenderer::finish(int exitCode)
+{
+    if (_finished) {
+        return;
+    }
+    _finished = true;
+
+    if (RenderTrace::self()->isEnabled()) {
+        qDebug().noquote() << RenderTrace::self()->summary();
+        if (!_traceFile.isEmpty() && RenderTrace::self()->writeChromeTrace(_traceFile)) {
+            qDebug() << "Render trace written to" << _traceFile;
+        }
+    }
+    emit finished(exitCode);
+}
+
+QString BatchRenderer::summary() const
+{
+    if (!_setupError.isEmpty()) {
+        return i18n("Rendering failed: %1", _setupError);
+    }
+
+    QString re = i18n("Rendered %1 of %2 archived documents.", _succeeded, _total);
+    if (!_failures.isEmpty()) {
+        re += QLatin1Char('\n') + i18n("%1 documents failed:", _failures.size());
+        QMapIterator<QString, QString> it(_failures);
+        while (it.hasNext()) {
+            it.next();
+            re += QString("\n  %1: %2").arg(it.key(), it.value());
+        }
+    }
+    return re;
+}
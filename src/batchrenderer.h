@@ -0,0 +1,104 @@
+/***************************************************************************
+            batchrenderer.h - render archived documents headless
+                             -------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by Klaas Freitag
+    email                : kraft@freisturz.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef BATCHRENDERER_H
+#define BATCHRENDERER_H
+
+#include <QObject>
+#include <QDate>
+#include <QList>
+#include <QMap>
+#include <QString>
+
+#include <kcontacts/addressee.h>
+
+#include "archdoc.h"
+
+class ReportGenerator;
+
+/**
+ * Renders all archived documents of a date range to PDF without any
+ * window. The document sources are expanded one after another on the
+ * main thread because the database connection is not shared, but the
+ * PDF converter processes run in parallel, one per available core.
+ *
+ * Used by the --render command line mode of kraft.
+ */
+class BatchRenderer : public QObject
+{
+    Q_OBJECT
+public:
+    enum ExitCode { Success = 0, DocumentsFailed = 1, SetupFailed = 2 };
+
+    explicit BatchRenderer(QObject *parent = nullptr);
+
+    void setDateRange(const QDate& from, const QDate& to);
+    void setOutputDir(const QString& dir);
+
+    // amount of converter processes running in parallel. Defaults to the
+    // amount of cores.
+    void setMaxJobs(int jobs);
+
+    // seconds after which a document that is not rendered yet counts as
+    // failed, so that a hanging converter does not stop the batch. 0
+    // waits forever. Defaults to 300 seconds.
+    void setJobTimeout(int secs);
+
+    // writes the RenderTrace spans as Chrome trace JSON at the end
+    void setTraceFile(const QString& file);
+
+    QString summary() const;
+
+    /*
+     * Connects the configured database for headless use. Returns false
+     * and sets error if it is not usable.
+     */
+    static bool connectDatabase(QString *error);
+
+signals:
+    void finished(int exitCode);
+
+public slots:
+    void start();
+
+private:
+    KContacts::Addressee myIdentity() const;
+    QList<ArchDocDigest> archivedDocuments() const;
+
+    void startNextJobs();
+    void jobDone(ReportGenerator *generator, const QString& error);
+    void finish(int exitCode);
+
+    QDate _from;
+    QDate _to;
+    QString _outputDir;
+    QString _traceFile;
+    int _maxJobs;
+    int _jobTimeout;
+
+    KContacts::Addressee _myContact;
+
+    QList<ArchDocDigest> _queue;
+    QMap<ReportGenerator*, QString> _running;
+    int _total;
+    int _succeeded;
+    QMap<QString, QString> _failures;
+    QString _setupError;
+    bool _finished;
+};
+
+#endif // BATCHRENDERER_H
@@ -23,6 +23,7 @@
 
 CatalogTemplate::CatalogTemplate()
   : m_calcType( Calculation ),
+  mSortKey(0),
   mUseCounter(0),
   mEntered( QDateTime::currentDateTime() ),
   mLastModified( QDateTime::currentDateTime() ),
@@ -36,6 +36,10 @@ class KRAFTCAT_EXPORT CatalogTemplate
 public:
   typedef enum { Unknown, ManualPrice, Calculation, AutoCalc } CalculationType;
 
+  // the distance of the sort keys, a new item is added behind the last
+  // one of its chapter with this gap
+  static const int SortKeyGap = 1024;
+
   CatalogTemplate();
   virtual ~CatalogTemplate();
 
@@ -70,6 +74,7 @@ public:
 
   Einheit unit() const;
   void setUnitId(int id);
+  int unitId() const { return mUnitId; }
 
 protected:
   virtual void saveChapterId();
@@ -0,0 +1,239 @@
+/***************************************************************************
+    converterworkerpool.cpp - pool of long running converter processes
+                             -------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by Klaas Freitag
+    email                : kraft@freisturz.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QJsonDocument>
+#include <QThread>
+#include <QDebug>
+
+#include "converterworkerpool.h"
+
+namespace {
+// After this amount of workers died before they were ready, the pool gives up.
+const int MaxStartFailures = 3;
+}
+
+ConverterWorkerPool::ConverterWorkerPool(const QString& program, const QStringList& arguments,
+                                         int maxWorkers, QObject *parent)
+    : QObject(parent),
+      _program(program),
+      _arguments(arguments),
+      _maxWorkers(maxWorkers > 0 ? maxWorkers : QThread::idealThreadCount()),
+      _nextJobId(1),
+      _startFailures(0),
+      _available(true)
+{
+    qRegisterMetaType<ConverterWorkerPool::Result>("ConverterWorkerPool::Result");
+}
+
+ConverterWorkerPool::~ConverterWorkerPool()
+{
+    // The workers terminate when their stdin is closed.
+    for (Worker *w : _workers) {
+        w->process->disconnect(this);
+        w->process->closeWriteChannel();
+        if (!w->process->waitForFinished(1000)) {
+            w->process->kill();
+            w->process->waitForFinished(1000);
+        }
+        delete w->process;
+        delete w;
+    }
+}
+
+int ConverterWorkerPool::submit(const QJsonObject& job)
+{
+    const int id = _nextJobId++;
+
+    if (!_available) {
+        // report asynchronously, as callers connect after submit
+        QMetaObject::invokeMethod(this, "jobFinished", Qt::QueuedConnection,
+                                  Q_ARG(int, id),
+                                  Q_ARG(ConverterWorkerPool::Result, Result::WorkerUnavailable),
+                                  Q_ARG(QString, QStringLiteral("Converter worker is not available")));
+        return id;
+    }
+
+    Job j;
+    j.job = job;
+    j.job.insert(QStringLiteral("id"), id);
+    _queue.append(j);
+
+    dispatch();
+    return id;
+}
+
+void ConverterWorkerPool::dispatch()
+{
+    int starting = 0;
+    for (Worker *w : _workers) {
+        if (_queue.isEmpty()) {
+            break;
+        }
+        if (!w->ready) {
+            starting++;
+            continue;
+        }
+        if (w->jobId > -1) {
+            continue;
+        }
+        const Job j = _queue.takeFirst();
+        w->job = j.job;
+        w->retries = j.retries;
+        w->jobId = j.job.value(QStringLiteral("id")).toInt();
+
+        QByteArray line = QJsonDocument(j.job).toJson(QJsonDocument::Compact);
+        line.append('\n');
+        w->process->write(line);
+    }
+
+    // start more workers if there are more queued jobs than starting workers
+    while (_queue.size() > starting && _workers.size() < _maxWorkers) {
+        startWorker();
+        starting++;
+    }
+}
+
+void ConverterWorkerPool::startWorker()
+{
+    Worker *w = new Worker;
+    w->process = new QProcess;
+    // worker log output goes to our stderr
+    w->process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+
+    connect(w->process, &QProcess::readyReadStandardOutput, this, &ConverterWorkerPool::slotReadyRead);
+    connect(w->process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, &ConverterWorkerPool::slotWorkerFinished);
+    connect(w->process, &QProcess::errorOccurred, this, &ConverterWorkerPool::slotWorkerError);
+
+    _workers.append(w);
+
+    qDebug() << "Starting converter worker" << _program << _arguments;
+    w->process->start(_program, _arguments);
+}
+
+ConverterWorkerPool::Worker *ConverterWorkerPool::workerFor(QObject *process) const
+{
+    for (Worker *w : _workers) {
+        if (w->process == process) {
+            return w;
+        }
+    }
+    return nullptr;
+}
+
+void ConverterWorkerPool::slotReadyRead()
+{
+    Worker *w = workerFor(sender());
+    if (!w) {
+        return;
+    }
+    w->buffer.append(w->process->readAllStandardOutput());
+
+    int pos;
+    while ((pos = w->buffer.indexOf('\n')) > -1) {
+        const QByteArray line = w->buffer.left(pos).trimmed();
+        w->buffer.remove(0, pos+1);
+        if (!line.isEmpty()) {
+            handleLine(w, line);
+        }
+    }
+}
+
+void ConverterWorkerPool::handleLine(Worker *w, const QByteArray& line)
+{
+    QJsonParseError parseError;
+    const QJsonObject answer = QJsonDocument::fromJson(line, &parseError).object();
+    if (parseError.error != QJsonParseError::NoError) {
+        qDebug() << "Converter worker sent garbage:" << line;
+        return;
+    }
+
+    const QString status = answer.value(QStringLiteral("status")).toString();
+    if (status == QLatin1String("ready")) {
+        w->ready = true;
+        _startFailures = 0;
+    } else if (w->jobId > -1 && answer.value(QStringLiteral("id")).toInt() == w->jobId) {
+        const int jobId = w->jobId;
+        w->jobId = -1;
+        w->job = QJsonObject();
+
+        if (status == QLatin1String("ok")) {
+            emit jobFinished(jobId, Result::Success, QString());
+        } else {
+            emit jobFinished(jobId, Result::Failed, answer.value(QStringLiteral("error")).toString());
+        }
+    } else {
+        qDebug() << "Converter worker answer for unknown job:" << line;
+    }
+    dispatch();
+}
+
+void ConverterWorkerPool::slotWorkerFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    qDebug() << "Converter worker terminated with exit code" << exitCode << exitStatus;
+    workerGone(qobject_cast<QProcess*>(sender()));
+}
+
+void ConverterWorkerPool::slotWorkerError(QProcess::ProcessError error)
+{
+    // on all other errors, the finished signal follows
+    if (error == QProcess::FailedToStart) {
+        qDebug() << "Converter worker failed to start:" << _program;
+        workerGone(qobject_cast<QProcess*>(sender()));
+    }
+}
+
+void ConverterWorkerPool::workerGone(QProcess *process)
+{
+    Worker *w = workerFor(process);
+    if (!w) {
+        return;
+    }
+    _workers.removeAll(w);
+    process->deleteLater();
+
+    if (!w->ready) {
+        _startFailures++;
+    }
+
+    // requeue the job the worker was working on once, it may have been the
+    // worker state rather than the document that was to blame.
+    if (w->jobId > -1) {
+        if (w->retries < 1) {
+            Job j;
+            j.job = w->job;
+            j.retries = w->retries + 1;
+            _queue.prepend(j);
+        } else {
+            emit jobFinished(w->jobId, Result::Failed, QStringLiteral("Converter worker crashed"));
+        }
+    }
+    delete w;
+
+    if (_startFailures >= MaxStartFailures) {
+        qDebug() << "Converter worker can not be started, giving up:" << _program << _arguments;
+        _available = false;
+        const QList<Job> queue = _queue;
+        _queue.clear();
+        for (const Job& j : queue) {
+            emit jobFinished(j.job.value(QStringLiteral("id")).toInt(), Result::WorkerUnavailable,
+                             QStringLiteral("Converter worker is not available"));
+        }
+        return;
+    }
+    dispatch();
+}
@@ -0,0 +1,114 @@
+/***************************************************************************
+     converterworkerpool.h - pool of long running converter processes
+                             -------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by Klaas Freitag
+    email                : kraft@freisturz.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef CONVERTERWORKERPOOL_H
+#define CONVERTERWORKERPOOL_H
+
+#include <QObject>
+#include <QList>
+#include <QPair>
+#include <QProcess>
+#include <QJsonObject>
+#include <QStringList>
+
+/**
+ * Manages long running converter worker processes, such as the
+ * weasyprintworker.py script, to avoid the interpreter startup for
+ * every document.
+ *
+ * The workers speak a line based protocol: Each job is written as one
+ * JSON object per line to the worker's stdin, and the worker answers
+ * with one JSON object per line on stdout, carrying the job id and a
+ * status of either "ok" or "error". After startup, a worker announces
+ * itself with {"status": "ready"}.
+ *
+ * Jobs from any number of converters are queued and dispatched to the
+ * next idle worker. Workers are started on demand up to the maximum
+ * amount. A worker that crashes is replaced, and the job it was working
+ * on is retried once.
+ */
+class ConverterWorkerPool : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Result { Success, Failed, WorkerUnavailable };
+
+    /*
+     * maxWorkers 0 means one worker per core.
+     */
+    ConverterWorkerPool(const QString& program, const QStringList& arguments,
+                        int maxWorkers = 0, QObject *parent = nullptr);
+    ~ConverterWorkerPool();
+
+    /*
+     * Queue a job. The id member of the job object is set by the pool.
+     * Returns the job id that is passed with jobFinished.
+     */
+    int submit(const QJsonObject& job);
+
+    /*
+     * false if the workers repeatedly failed to start, ie. because the
+     * required python modules are missing. Jobs are not accepted anymore
+     * then and callers should fall back to something else.
+     */
+    bool isAvailable() const { return _available; }
+
+    int maxWorkers() const { return _maxWorkers; }
+
+signals:
+    void jobFinished(int jobId, ConverterWorkerPool::Result result, const QString& error);
+
+private slots:
+    void slotReadyRead();
+    void slotWorkerFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void slotWorkerError(QProcess::ProcessError error);
+
+private:
+    struct Worker {
+        QProcess *process {nullptr};
+        bool ready {false};
+        int jobId {-1};
+        QJsonObject job;
+        int retries {0};
+        QByteArray buffer;
+    };
+
+    struct Job {
+        QJsonObject job;
+        int retries {0};
+    };
+
+    void dispatch();
+    void startWorker();
+    void handleLine(Worker *w, const QByteArray& line);
+    void workerGone(QProcess *process);
+    Worker *workerFor(QObject *process) const;
+
+    QString _program;
+    QStringList _arguments;
+    int _maxWorkers;
+    int _nextJobId;
+    int _startFailures;
+    bool _available;
+
+    QList<Worker*> _workers;
+    QList<Job> _queue;
+};
+
+Q_DECLARE_METATYPE(ConverterWorkerPool::Result)
+
+#endif // CONVERTERWORKERPOOL_H
@@ -31,6 +31,11 @@
 #include "archdoc.h"
 #include "format.h"
 
+namespace {
+// milliseconds between two selections below which rendering is deferred
+const int DocDetailsDelay = 120;
+}
+
 DocDigestHtmlView::DocDigestHtmlView( QWidget *parent )
   : HtmlView( parent )
 {
@@ -116,10 +121,17 @@ DocDigestDetailView::DocDigestDetailView(QWidget *parent) :
   _rightDetails->setTextInteractionFlags(Qt::TextSelectableByMouse);
 
   hbox->addWidget(_rightDetails);
+
+  _docDetailsTimer.setSingleShot(true);
+  _docDetailsTimer.setInterval(DocDetailsDelay);
+  connect(&_docDetailsTimer, &QTimer::timeout, this, &DocDigestDetailView::slotShowPendingDocDetails);
+
+  _docHtmlCache.setMaxCost(200);
 }
 
 void DocDigestDetailView::slotClearView()
 {
+    _docDetailsTimer.stop();
     const QString details;
     mHtmlCanvas->displayContent( details );
 }
@@ -248,6 +260,8 @@ void DocDigestDetailView::documentListing( TextTemplate *tmpl, int year, int mon
 
 void DocDigestDetailView::slotShowMonthDetails( int year, int month )
 {
+    _docDetailsTimer.stop();
+
     if( _monthTemplFileName.isEmpty() ) {
         _monthTemplFileName = DefaultProvider::self()->locateFile( "views/monthdigest.thtml" );
     }
@@ -282,6 +296,8 @@ void DocDigestDetailView::slotShowMonthDetails( int year, int month )
 
 void DocDigestDetailView::slotShowYearDetails( int year )
 {
+    _docDetailsTimer.stop();
+
     if( _yearTemplFileName.isEmpty() ) {
         _yearTemplFileName = DefaultProvider::self()->locateFile( "views/yeardigest.thtml" );
     }
@@ -397,7 +413,61 @@ void DocDigestDetailView::showAddress( const KContacts::Addressee& addressee, co
 void DocDigestDetailView::slotShowDocDetails( DocDigest digest )
 {
     // qDebug () << "Showing details about this doc: " << digest.id();
+    _pendingDigest = digest;
+
+    // render right away, unless the previous selection was only a moment ago
+    const bool quick = _lastDocDetailsRequest.isValid() && _lastDocDetailsRequest.elapsed() < DocDetailsDelay;
+    _lastDocDetailsRequest.start();
+
+    if (quick) {
+        _docDetailsTimer.start();
+    } else {
+        _docDetailsTimer.stop();
+        showDocDetails(digest);
+    }
+}
+
+void DocDigestDetailView::slotShowPendingDocDetails()
+{
+    showDocDetails(_pendingDigest);
+}
+
+void DocDigestDetailView::showDocDetails( const DocDigest& digest )
+{
+    showAddress( digest.addressee(), digest.clientAddress() );
+
+    // The HTML depends on the document, its archived versions and if the
+    // PDF of the latest one exists.
+    const ArchDocDigestList archDocs = digest.archDocDigestList();
+    QString key = QStringList({digest.id(), digest.lastModified(), digest.date(),
+                               digest.projectLabel(), digest.whiteboard()}).join(QLatin1Char('|'));
+    if (!archDocs.isEmpty()) {
+        const ArchDocDigest& latest = archDocs.first();
+        key += QString("|%1|%2|%3").arg(archDocs.size()).arg(latest.archDocId().toString())
+                .arg(QFileInfo::exists(latest.pdfArchiveFileName()) ? 1 : 0);
+    }
+
+    if (QString *html = _docHtmlCache.object(key)) {
+        mHtmlCanvas->displayContent( *html );
+    } else {
+        const QString details = docDetailsHtml(digest, archDocs);
+        if (details.isEmpty()) {
+            return;
+        }
+        _docHtmlCache.insert(key, new QString(details));
+        mHtmlCanvas->displayContent( details );
+    }
+
+    _rightDetails->setText(digest.whiteboard());
+    _leftDetails->setStyleSheet(widgetStylesheet(Left, Document));
+    _leftDetails->setAlignment(Qt::AlignLeft);
 
+    _rightDetails->setStyleSheet(widgetStylesheet(Right, Document));
+    // qDebug () << "BASE-URL of htmlview is " << mHtmlCanvas->baseURL();
+}
+
+QString DocDigestDetailView::docDetailsHtml( const DocDigest& digest, const ArchDocDigestList& archDocs )
+{
     if( _docTemplFileName.isEmpty() ) {
         // QString templFileName = QString( "kraftdoc_%1_ro.trml" ).arg( doc->docType() );
         _docTemplFileName = DefaultProvider::self()->locateFile( "views/docdigest.thtml" );
@@ -406,7 +476,7 @@ void DocDigestDetailView::slotShowDocDetails( DocDigest digest )
     TextTemplate tmpl; // template file with name docdigest.trml
     tmpl.setTemplateFileName(_docTemplFileName);
     if( !tmpl.isOk() ) {
-        return;
+        return QString();
     }
     tmpl.setValue( DOCDIGEST_TAG( "HEADLINE" ), digest.type() + " " + digest.ident() );
 
@@ -424,10 +494,7 @@ void DocDigestDetailView::slotShowDocDetails( DocDigest digest )
         tmpl.setValue( "PROJECT_INFO", DOCDIGEST_TAG( "PROJECT_LABEL"), i18n("Project"));
     }
 
-    showAddress( digest.addressee(), digest.clientAddress() );
-
     // Information about archived documents.
-    ArchDocDigestList archDocs = digest.archDocDigestList();
     if( archDocs.isEmpty() ) {
         // qDebug () << "No archived docs for this document!";
         tmpl.createDictionary( DOCDIGEST_TAG( "NEVER_PRINTED" ));
@@ -460,13 +527,5 @@ void DocDigestDetailView::slotShowDocDetails( DocDigest digest )
         }
     }
 
-    const QString details = tmpl.expand();
-    mHtmlCanvas->displayContent( details );
-
-    _rightDetails->setText(digest.whiteboard());
-    _leftDetails->setStyleSheet(widgetStylesheet(Left, Document));
-    _leftDetails->setAlignment(Qt::AlignLeft);
-
-    _rightDetails->setStyleSheet(widgetStylesheet(Right, Document));
-    // qDebug () << "BASE-URL of htmlview is " << mHtmlCanvas->baseURL();
+    return tmpl.expand();
 }
@@ -19,6 +19,9 @@
 
 #include <QWidget>
 #include <QLabel>
+#include <QCache>
+#include <QElapsedTimer>
+#include <QTimer>
 
 #include "docdigest.h"
 #include "htmlview.h"
@@ -59,7 +62,12 @@ public slots:
   void slotShowMonthDetails( int year, int month );
   void slotShowYearDetails( int year);
 
+private slots:
+  void slotShowPendingDocDetails();
+
 private:
+  void showDocDetails( const DocDigest& digest );
+  QString docDetailsHtml( const DocDigest& digest, const ArchDocDigestList& archDocs );
   void showAddress( const KContacts::Addressee& addressee, const QString& manAddress );
     void documentListing( TextTemplate *tmpl, int year, int month );
 
@@ -74,6 +82,15 @@ private:
   QString   _docTemplFileName;
   QString   _monthTemplFileName;
   QString   _yearTemplFileName;
+
+  // rendering is deferred while the selection changes quickly, ie. when
+  // the arrow key is held down in the document list.
+  QTimer        _docDetailsTimer;
+  QElapsedTimer _lastDocDetailsRequest;
+  DocDigest     _pendingDigest;
+
+  // the expanded HTML per document, see docDetailsHtml for the key
+  QCache<QString, QString> _docHtmlCache;
 };
 
 #endif // DOCDIGESTDETAILVIEW_H
@@ -38,7 +38,9 @@ DocPositionBase::DocPositionBase() : QObject(),
                                      mToDelete( false ),
                                      mTaxType( TaxFull ),
                                      mType( Position ),
-                                     mAttribs( QString::fromLatin1( "Position" ) )
+                                     mAttribs( QString::fromLatin1( "Position" ) ),
+                                     mHasKind( false ),
+                                     mRevision( ++sNextRevision )
 
 {
 
@@ -50,7 +52,9 @@ DocPositionBase::DocPositionBase( const PositionType& t )
     mToDelete( false ),
     mTaxType( TaxFull ),
     mType( t ),
-    mAttribs( QString::fromLatin1( "Position" ) )
+    mAttribs( QString::fromLatin1( "Position" ) ),
+    mHasKind( false ),
+    mRevision( ++sNextRevision )
 {
 
 }
@@ -63,7 +67,9 @@ DocPositionBase::DocPositionBase(const DocPositionBase& b )
     mToDelete( b.mToDelete ),
     mTaxType( TaxFull ),
     mType( b.mType ),
-    mAttribs( b.mAttribs )
+    mAttribs( b.mAttribs ),
+    mHasKind( b.mHasKind ),
+    mRevision( ++sNextRevision )
 {
 
 }
@@ -79,14 +85,24 @@ DocPositionBase& DocPositionBase::operator=( const DocPositionBase& dp )
   mType = dp.mType;
   mAttribs = dp.mAttribs;
   mTaxType = dp.mTaxType;
+  touch();
 
   return *this;
 }
 
+QAtomicInteger<quint64> DocPositionBase::sNextRevision;
+
+void DocPositionBase::touch()
+{
+  mHasKind = mAttribs.contains( DocPosition::Kind );
+  mRevision = ++sNextRevision;
+}
+
 void DocPositionBase::setAttribute( const Attribute& attrib )
 {
   if( ! attrib.name().isEmpty() ) {
       mAttribs[ attrib.name() ] = attrib;
+      touch();
   }
 }
 
@@ -98,6 +114,7 @@ AttributeMap DocPositionBase::attributes()
 void DocPositionBase::setAttributeMap( AttributeMap attmap )
 {
   mAttribs = attmap;
+  touch();
 }
 
 void DocPositionBase::loadAttributes()
@@ -107,12 +124,15 @@ void DocPositionBase::loadAttributes()
     return;
   }
   mAttribs.load( m_dbId );
+  touch();
 }
 
 void DocPositionBase::removeAttribute( const QString& name )
 {
-  if ( !name.isEmpty() )
+  if ( !name.isEmpty() ) {
     mAttribs.markDelete( name );
+    touch();
+  }
 }
 
 QString DocPositionBase::attribute( const QString& attName ) const
@@ -189,11 +209,13 @@ DocPositionBase::TaxType DocPositionBase::taxType()
 void DocPositionBase::setTaxType( TaxType tt )
 {
   mTaxType = tt;
+  touch();
 }
 
 void DocPositionBase::setTaxType( int tt )
 {
   mTaxType = (TaxType) tt;
+  touch();
 }
 
 int DocPositionBase::taxTypeNumeric()
@@ -232,10 +254,9 @@ DocPosition::DocPosition( const PositionType& t )
 Geld DocPosition::overallPrice()
 {
     Geld g;
-    AttributeMap atts = attributes();
     // all kinds beside from no kind mean  that the position is not
     // counted for the overall price. That's a FIXME
-    if ( ! atts.contains( DocPosition::Kind ) ) {
+    if ( ! mHasKind ) {
       g = unitPrice() * amount();
     }
     return g;
@@ -243,89 +264,140 @@ Geld DocPosition::overallPrice()
 
 // ##############################################################
 
-DocPositionList::DocPositionList()
-  : QList<DocPositionBase*>()
+DocTotals::DocTotals()
+  : mCount( 0 ),
+    mFullTaxCount( 0 ),
+    mReducedTaxCount( 0 ),
+    mNoTaxCount( 0 )
 {
-  // setAutoDelete( true );
-}
 
-Geld DocPositionList::bruttoPrice(double fullTax, double reducedTax )
-{
-  Geld g = nettoPrice();
-  g += taxSum( fullTax, reducedTax );
-  return g;
 }
 
-Geld DocPositionList::nettoPrice()
+void DocTotals::addPosition( const Geld& price, DocPositionBase::TaxType taxType )
 {
-  Geld g;
+  mNetto += price;
+  mCount++;
 
-  DocPositionListIterator it( *this );
-  while( it.hasNext() ) {
-    g += static_cast<DocPosition*>(it.next())->overallPrice();
+  if ( taxType == DocPositionBase::TaxFull ) {
+    mFullTaxBase += price;
+    mFullTaxCount++;
+  } else if ( taxType == DocPositionBase::TaxReduced ) {
+    mReducedTaxBase += price;
+    mReducedTaxCount++;
+  } else if ( taxType == DocPositionBase::TaxNone ) {
+    mNoTaxCount++;
   }
-  return g;
 }
 
-Geld DocPositionList::fullTaxSum( double fullTax )
+Geld DocTotals::fullTax( double fullTax ) const
 {
-  Geld sum;
-
-  if ( fullTax < 0 ) {
-    qCritical() << "Full Tax is not loaded!";
-  }
-  DocPositionListIterator it( *this );
-  while( it.hasNext() ) {
-    DocPosition *dp = static_cast<DocPosition*>( it.next() );
-
-    if( dp->taxTypeNumeric() == DocPositionBase::TaxFull ) {
-        sum += dp->overallPrice();
-    }
+  Geld base = mFullTaxBase;
+  Geld tax;
+  if( base.toLong() > 0 ) {
+      tax = base.percent(fullTax);
   }
+  return tax;
+}
 
+Geld DocTotals::reducedTax( double reducedTax ) const
+{
+  Geld base = mReducedTaxBase;
   Geld tax;
-  if( sum.toLong() > 0 ) {
-      tax = sum.percent(fullTax);
+  if( base.toLong() > 0 ) {
+      tax = base.percent(reducedTax);
   }
-
   return tax;
 }
 
-Geld DocPositionList::reducedTaxSum( double reducedTax )
+Geld DocTotals::taxSum( double fullTax, double reducedTax ) const
 {
-  Geld sum;
+  Geld sum = this->fullTax( fullTax );
+  sum += this->reducedTax( reducedTax );
+  return sum;
+}
 
-  if ( reducedTax < 0 ) {
-    qCritical() << "Reduced Tax is not loaded!";
+Geld DocTotals::brutto( double fullTax, double reducedTax ) const
+{
+  Geld g = mNetto;
+  g += taxSum( fullTax, reducedTax );
+  return g;
+}
+
+int DocTotals::count( DocPositionBase::TaxType taxType ) const
+{
+  if ( taxType == DocPositionBase::TaxFull ) {
+    return mFullTaxCount;
+  } else if ( taxType == DocPositionBase::TaxReduced ) {
+    return mReducedTaxCount;
+  } else if ( taxType == DocPositionBase::TaxNone ) {
+    return mNoTaxCount;
   }
-  DocPositionListIterator it( *this );
-  while( it.hasNext() ) {
-    DocPosition *dp = static_cast<DocPosition*>( it.next() );
+  return 0;
+}
 
-    if( dp->taxTypeNumeric() == DocPositionBase::TaxReduced ) {
-        sum += dp->overallPrice();
-    }
+// ##############################################################
+
+DocPositionList::DocPositionList()
+  : QList<DocPositionBase*>()
+{
+  // setAutoDelete( true );
+}
+
+const DocTotals& DocPositionList::totals() const
+{
+  // only changes of the own positions make the totals stale
+  bool valid = ( mTotalsPositions == *this );
+  for ( int i = 0; valid && i < size(); i++ ) {
+    valid = ( at(i)->revision() == mTotalsRevisions.at(i) );
+  }
+  if ( valid ) {
+    return mTotals;
   }
 
-  Geld tax;
-  if(sum.toLong() > 0 ) {
-      tax = sum.percent(reducedTax);
+  DocTotals totals;
+  QVector<quint64> revisions;
+  revisions.reserve( size() );
+  for ( DocPositionBase *dpb : *this ) {
+    DocPosition *dp = static_cast<DocPosition*>( dpb );
+    totals.addPosition( dp->overallPrice(), dp->taxType() );
+    revisions.append( dp->revision() );
   }
+  mTotals = totals;
+  mTotalsPositions = *this;
+  mTotalsRevisions = revisions;
 
-  return tax;
+  return mTotals;
 }
 
-Geld DocPositionList::taxSum( double fullTax, double redTax )
+Geld DocPositionList::bruttoPrice(double fullTax, double reducedTax )
 {
-  Geld sum;
+  return totals().brutto( fullTax, reducedTax );
+}
+
+Geld DocPositionList::nettoPrice()
+{
+  return totals().netto();
+}
 
-  Geld fulltax = fullTaxSum(fullTax);
-  Geld reducedtax = reducedTaxSum(redTax);
+Geld DocPositionList::fullTaxSum( double fullTax )
+{
+  if ( fullTax < 0 ) {
+    qCritical() << "Full Tax is not loaded!";
+  }
+  return totals().fullTax( fullTax );
+}
 
-  sum += fulltax;
-  sum += reducedtax;
+Geld DocPositionList::reducedTaxSum( double reducedTax )
+{
+  if ( reducedTax < 0 ) {
+    qCritical() << "Reduced Tax is not loaded!";
+  }
+  return totals().reducedTax( reducedTax );
+}
 
-  return sum;
+Geld DocPositionList::taxSum( double fullTax, double redTax )
+{
+  return totals().taxSum( fullTax, redTax );
 }
 
 QString DocPositionList::posNumber( DocPositionBase* pos )
@@ -22,6 +22,8 @@
 #include <QObject>
 
 #include <QList>
+#include <QVector>
+#include <QAtomicInteger>
 
 // application specific includes
 #include "dbids.h"
@@ -87,7 +89,24 @@ class DocPositionBase : public QObject
 
     DocPositionBase& operator=( const DocPositionBase& );
 
+    /**
+     * true if the position has a kind attribute, such as alternative or
+     * on demand. These positions do not count for the sums.
+     */
+    bool hasKind() const { return mHasKind; }
+
+    /**
+     * Changes whenever a value of the position changes that affects the
+     * sums. The position lists compare it to tell if their cached totals
+     * are stale. Unique over all positions, so that a new position is
+     * never taken for the one it replaces.
+     */
+    quint64 revision() const { return mRevision; }
+
   protected:
+    // to be called whenever a value changes that affects the sums
+    void touch();
+
     int     m_dbId;
     int     m_position;
     QString m_text;
@@ -95,6 +114,11 @@ class DocPositionBase : public QObject
     TaxType mTaxType;
     PositionType mType;
     AttributeMap mAttribs;
+    bool    mHasKind;
+
+  private:
+    quint64 mRevision;
+    static QAtomicInteger<quint64> sNextRevision;
 };
 
 
@@ -109,11 +133,11 @@ class DocPosition : public DocPositionBase
     void setUnit( const Einheit& unit ) { m_unit = unit; }
     Einheit unit() const { return m_unit; }
 
-    void setUnitPrice( const Geld& g ) { m_unitPrice = g; }
+    void setUnitPrice( const Geld& g ) { m_unitPrice = g; touch(); }
     Geld unitPrice() const { return m_unitPrice; }
     Geld overallPrice();
 
-    void setAmount( double amount ) { m_amount = amount; }
+    void setAmount( double amount ) { m_amount = amount; touch(); }
     double amount() { return m_amount; }
     
     PositionViewWidget* associatedWidget() { return mWidget; }
@@ -134,11 +158,54 @@ class DocPosition : public DocPositionBase
 
 };
 
+/**
+ * The sums of a list of positions, collected in one pass over the list:
+ * The netto sum and the parts of it that are subject to the full and
+ * the reduced tax. The taxes and the brutto sum are derived from these
+ * for the given tax rates.
+ */
+class DocTotals
+{
+  public:
+    DocTotals();
+
+    void addPosition( const Geld& price, DocPositionBase::TaxType taxType );
+
+    Geld netto() const { return mNetto; }
+    Geld fullTaxBase() const { return mFullTaxBase; }
+    Geld reducedTaxBase() const { return mReducedTaxBase; }
+
+    // the taxes are zero if the base is not positive
+    Geld fullTax( double fullTax ) const;
+    Geld reducedTax( double reducedTax ) const;
+    Geld taxSum( double fullTax, double reducedTax ) const;
+    Geld brutto( double fullTax, double reducedTax ) const;
+
+    // amount of positions, all or of the given tax type
+    int count() const { return mCount; }
+    int count( DocPositionBase::TaxType taxType ) const;
+
+  private:
+    Geld mNetto;
+    Geld mFullTaxBase;
+    Geld mReducedTaxBase;
+    int  mCount;
+    int  mFullTaxCount;
+    int  mReducedTaxCount;
+    int  mNoTaxCount;
+};
+
 class DocPositionList : public QList<DocPositionBase*>
 {
   public:
     DocPositionList();
 
+    /**
+     * The sums of all positions. They are computed in one pass and
+     * cached until a position or the list changes.
+     */
+    const DocTotals& totals() const;
+
     QDomElement domElement( QDomDocument& );
     DocPositionBase *positionFromId( int id );
     QString posNumber( DocPositionBase* );
@@ -154,6 +221,11 @@ class DocPositionList : public QList<DocPositionBase*>
 
   private:
     QDomElement xmlTextElement( QDomDocument&, const QString& , const QString& );
+
+    mutable DocTotals mTotals;
+    // the positions and their revisions the totals were computed from
+    mutable QList<DocPositionBase*> mTotalsPositions;
+    mutable QVector<quint64> mTotalsRevisions;
 };
 
 typedef QListIterator<DocPositionBase*> DocPositionListIterator;
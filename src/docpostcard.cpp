@@ -24,11 +24,12 @@
 #include <QStandardPaths>
 #include <QDebug>
 #include <QTextDocument>
+#include <QScrollBar>
 
 #define QL1(X) QLatin1String(X)
 
 DocPostCard::DocPostCard( QWidget *parent )
-    :HtmlView( parent ),  mMode( Full ), mShowPrices(true)
+    :HtmlView( parent ), mPositionCount( 0 ), mMode( Full ), mShowPrices(true)
 {
   setStylesheetFile( "docoverview.css" );
   setTitle( i18n( "Document Overview" ) );
@@ -56,103 +57,161 @@ QString DocPostCard::htmlify( const QString& str ) const
 #define REDUCED_TAX_MARK "&#xB2;"
 #define NO_TAX_MARK "&#xB9;"
 
+bool DocPostCard::Row::operator==( const Row& other ) const
+{
+  return number == other.number && text == other.text && price == other.price &&
+      taxMark == other.taxMark && deleted == other.deleted && kind == other.kind;
+}
+
+QString DocPostCard::rowHtml( const Row& row ) const
+{
+  const QString strikeOn = row.deleted ? QL1("<strike>") : QString();
+  const QString strikeOff = row.deleted ? QL1("</strike>") : QString();
+
+  QString t = QL1("<tr><td valign=\"top\" width=\"20\" class=\"itemnums\">");
+  t += strikeOn + row.number + QL1(". ") + strikeOff;
+  t += QL1("</td><td class=\"itemtexts\">") + strikeOn;
+
+  if ( row.kind ) {
+      t += QL1("<i>") + row.text + QL1("</i>");
+  } else {
+      t += htmlify( row.text );
+  }
+  t += strikeOff + QL1("</td>");
+
+  if( mShowPrices ) {
+      t += QL1("<td align=\"right\" valign=\"bottom\" class=\"prices\">");
+      t += strikeOn + row.price + strikeOff;
+      t += QL1("</td><td align=\"right\" valign=\"bottom\" width=\"12\">");
+      if( !row.taxMark.isEmpty() ) {
+          t += strikeOn + row.taxMark + strikeOff;
+      }
+      t += QL1("</td>");
+  }
+  t += QL1("</tr>");
+  return t;
+}
+
+/*
+ * The positions block consists of one cached html snippet per row and the
+ * totals. Only rows whose content changed since the last call are rendered
+ * again, which keeps typing in big documents fluent. The sums come from
+ * the totals of the list.
+ */
 void DocPostCard::setPositions( DocPositionList posList, DocPositionBase::TaxType taxType,
                                 double tax, double reducedTax )
 {
-  mPositions = "<div  align=\"right\"><table border=\"0\" width=\"99%\">";
-
-  DocPositionListIterator it(posList);
-  while( it.hasNext() ) {
-      DocPositionBase *dpb = it.next();
-      DocPosition *dp = static_cast<DocPosition*>(dpb);
-      mPositions += "<tr><td valign=\"top\" width=\"20\" class=\"itemnums\">";
-
-      if ( dp->toDelete() ) mPositions += "<strike>";
-      mPositions += posList.posNumber( dpb ) + ". ";
-      if ( dp->toDelete() ) mPositions += "</strike>";
-      mPositions += "</td>";
-      mPositions += "<td class=\"itemtexts\">";
-      if ( dp->toDelete() ) mPositions += "<strike>";
-
-      if ( dp->attributes().contains( DocPosition::Kind ) ) {
-          mPositions += "<i>" + dp->text() + "</i>";
-      } else {
-          mPositions += htmlify(dp->text());
+  bool changed = ( posList.count() != mRows.count() );
+  mRows.resize( posList.count() );
+
+  for( int i = 0; i < posList.count(); i++ ) {
+      DocPosition *dp = static_cast<DocPosition*>( posList.at(i) );
+      Row row;
+      row.number = QString::number( i+1 );
+      row.text = dp->text();
+      row.deleted = dp->toDelete();
+      row.kind = dp->hasKind();
+      if( mShowPrices ) {
+          row.price = dp->overallPrice().toHtmlString();
+          if( taxType == DocPositionBase::TaxIndividual ) {
+              if( dp->taxType() == DocPositionBase::TaxReduced ) {
+                  row.taxMark = QL1(REDUCED_TAX_MARK);
+              } else if( dp->taxType() == DocPositionBase::TaxNone ) {
+                  row.taxMark = QL1(NO_TAX_MARK);
+              }
+          }
       }
 
-      if ( dp->toDelete() ) mPositions += "</strike>";
-      mPositions += "</td>";
+      Row& cached = mRows[i];
+      if( cached.html.isEmpty() || !(cached == row) ) {
+          row.html = rowHtml( row );
+          cached = row;
+          changed = true;
+      }
+  }
 
-      if( mShowPrices ) {
-          mPositions += "<td align=\"right\" valign=\"bottom\" class=\"prices\">";
-          if ( dp->toDelete() ) mPositions += "<strike>";
-          mPositions += dp->overallPrice().toHtmlString();
-          if ( dp->toDelete() ) mPositions += "</strike>";
-          mPositions += "</td>";
-
-          mPositions += "<td align=\"right\" valign=\"bottom\" width=\"12\">";
-          if( taxType == DocPositionBase::TaxIndividual && (dp->taxType() == DocPositionBase::TaxReduced) ) {
-              if ( dp->toDelete() ) mPositions += "<strike>";
-              mPositions += QString(REDUCED_TAX_MARK);
-              if ( dp->toDelete() ) mPositions += "</strike>";
-          }
+  const DocTotals& totals = posList.totals();
+  mPositionCount = posList.count();
+  mTotal = totals.netto().toHtmlString();
 
-          if( taxType == DocPositionBase::TaxIndividual && (dp->taxType() == DocPositionBase::TaxNone) ) {
-              if ( dp->toDelete() ) mPositions += "<strike>";
-              mPositions += QString(NO_TAX_MARK);
-              if ( dp->toDelete() ) mPositions += "</strike>";
-          }
-          mPositions += "</td>";
+  changed = setTotals( taxType, tax, reducedTax, totals ) || changed;
+
+  if( changed ) {
+      QString positions = QL1("<div  align=\"right\"><table border=\"0\" width=\"99%\">");
+      for( const Row& row : mRows ) {
+          positions += row.html;
       }
-      mPositions += "</tr>";
+      positions += QL1("</table></div>");
+      positions += mTotalsHtml;
+      mPositions = positions;
+  }
+  // qDebug() << "Positions-HTML: " << mPositions << endl;
+}
+
+/*
+ * Renders the sum table into mTotalsHtml if one of its values changed.
+ * Returns true if it was rendered.
+ */
+bool DocPostCard::setTotals( DocPositionBase::TaxType taxType, double tax, double reducedTax,
+                             const DocTotals& totals )
+{
+  if( mShowPrices && tax < 0 ) {
+      qCritical() << "Full Tax is not loaded!";
+  }
+  if( mShowPrices && reducedTax < 0 ) {
+      qCritical() << "Reduced Tax is not loaded!";
+  }
 
+  const Geld fullTaxSum = totals.fullTax( tax );
+  const Geld reducedTaxSum = totals.reducedTax( reducedTax );
+  const Geld taxSum = totals.taxSum( tax, reducedTax );
+  const Geld brutto = totals.brutto( tax, reducedTax );
+
+  const QString key = QStringList( { QString::number( mShowPrices ), QString::number( taxType ),
+                                     QString::number( tax ), QString::number( reducedTax ),
+                                     mTotal, fullTaxSum.toHtmlString(),
+                                     reducedTaxSum.toHtmlString() } ).join( QChar('|') );
+  if( key == mTotalsKey ) {
+      return false;
   }
-  mPositions += "</table></div>";
+  mTotalsKey = key;
 
-  // Create the sum table
-  mPositionCount = posList.count();
+  QString t;
   if( mShowPrices ) {
-      mPositions += "<div align=\"right\"><table border=\"0\" width=\"66%\">";
-      mPositionCount = posList.count();
-      mTotal  = posList.nettoPrice().toHtmlString();
-      QString brutto = posList.bruttoPrice( tax, reducedTax ).toHtmlString();
-      mPositions += QString( "<tr><td align=\"right\" colspan=\"2\" class=\"baseline\">______________________________</td><td width=\"12\" align=\"right\"></td></tr>" );
+      t += "<div align=\"right\"><table border=\"0\" width=\"66%\">";
+      t += QString( "<tr><td align=\"right\" colspan=\"2\" class=\"baseline\">______________________________</td><td width=\"12\" align=\"right\"></td></tr>" );
 
       if ( taxType != DocPositionBase::TaxInvalid && taxType != DocPositionBase::TaxNone ) {
-          mPositions += QString( "<tr><td align=\"right\">" ) + i18n( "Netto:" )+
+          t += QString( "<tr><td align=\"right\">" ) + i18n( "Netto:" )+
                   QString( "</td><td align=\"right\">%1</td><td width=\"12\" align=\"right\"></td></tr>" ).arg( mTotal );
 
           QString curTax;
-          curTax.setNum( tax, 'f', 1 );
-          QString taxStr;
 
           if( taxType == DocPositionBase::TaxReduced || taxType == DocPositionBase::TaxIndividual ) {
               curTax.setNum( reducedTax, 'f', 1 );
-              taxStr = posList.reducedTaxSum( reducedTax ).toHtmlString();
-              mPositions += QString( "<tr><td align=\"right\">" );
-              mPositions += i18n( "+ %1% Tax:", curTax ) +
-                      QString( "</td><td align=\"right\">%1</td><td width=\"12\" align=\"right\">%2</td></tr>" ).arg( taxStr ).arg(REDUCED_TAX_MARK);
+              t += QString( "<tr><td align=\"right\">" );
+              t += i18n( "+ %1% Tax:", curTax ) +
+                      QString( "</td><td align=\"right\">%1</td><td width=\"12\" align=\"right\">%2</td></tr>" ).arg( reducedTaxSum.toHtmlString() ).arg(REDUCED_TAX_MARK);
           }
 
           if( taxType == DocPositionBase::TaxFull || taxType == DocPositionBase::TaxIndividual ) {
               curTax.setNum( tax, 'f', 1 );
-              taxStr = posList.fullTaxSum( tax ).toHtmlString();
-              mPositions += QString( "<tr><td align=\"right\">" ) + i18n( "+ %1% Tax:", curTax ) +
-                      QString( "</td><td align=\"right\">%1</td><td width=\"12\" align=\"right\"></td></tr>" ).arg( taxStr );
+              t += QString( "<tr><td align=\"right\">" ) + i18n( "+ %1% Tax:", curTax ) +
+                      QString( "</td><td align=\"right\">%1</td><td width=\"12\" align=\"right\"></td></tr>" ).arg( fullTaxSum.toHtmlString() );
           }
 
           if( taxType == DocPositionBase::TaxIndividual ) {
-              taxStr = posList.taxSum( tax, reducedTax ).toHtmlString();
-              mPositions += QString( "<tr><td align=\"right\">" ) + i18n( "Sum Tax:" ) +
-                      QString( "</td><td align=\"right\">%1</td><td width=\"12\" align=\"right\"></td></tr>" ).arg( taxStr );
+              t += QString( "<tr><td align=\"right\">" ) + i18n( "Sum Tax:" ) +
+                      QString( "</td><td align=\"right\">%1</td><td width=\"12\" align=\"right\"></td></tr>" ).arg( taxSum.toHtmlString() );
           }
 
       }
-      mPositions += QString( "<tr><td align=\"right\"><b>" ) + i18n( "Total:" )+
-              QString( "</b></td><td align=\"right\"><b>%1</b></td><td width=\"12\" align=\"right\"></td></tr>" ).arg( brutto );
+      t += QString( "<tr><td align=\"right\"><b>" ) + i18n( "Total:" )+
+              QString( "</b></td><td align=\"right\"><b>%1</b></td><td width=\"12\" align=\"right\"></td></tr>" ).arg( brutto.toHtmlString() );
   } // showPrices
-  mPositions += "</table></div>";
-  // qDebug() << "Positions-HTML: " << mPositions << endl;
+  t += "</table></div>";
+  mTotalsHtml = t;
+  return true;
 }
 
 void DocPostCard::setFooterData( const QString& postText,  const QString& goodbye )
@@ -175,7 +234,16 @@ void DocPostCard::renderDoc( int id )
   }
 
   // qDebug() << t << endl;
+  // typing in a field that is not shown on the postcard changes nothing
+  if ( t == mDisplayedHtml ) {
+    return;
+  }
+  mDisplayedHtml = t;
+
+  // keep the scroll position while the document is edited
+  const int scrollPos = verticalScrollBar()->value();
   displayContent( t );
+  verticalScrollBar()->setValue( scrollPos );
 }
 
 #define SEL_STRING(X) ( id == X ? QL1("_selected"): QL1(""))
@@ -304,5 +372,10 @@ void DocPostCard::slotSetMode( DisplayMode mode, int id ) {
 
 void DocPostCard::slotShowPrices( bool showIt )
 {
+    if( showIt != mShowPrices ) {
+        // the rows contain the price columns, render all again
+        mRows.clear();
+        mTotalsKey.clear();
+    }
     mShowPrices = showIt;
 }
@@ -19,6 +19,7 @@
 #define DOCPOSTCARD_H
 
 #include <qstring.h>
+#include <QVector>
 #include "htmlview.h"
 #include "kraftdoc.h"
 
@@ -53,7 +54,22 @@ private slots:
   void slotUrlSelected( const QUrl& kurl);
 
 private:
+  // one position row of the postcard with the html rendered from it
+  struct Row {
+    QString number;
+    QString text;
+    QString price;
+    QString taxMark;
+    bool deleted = false;
+    bool kind = false;
+    QString html;
+
+    bool operator==( const Row& other ) const;
+  };
+
   QString htmlify( const QString& ) const;
+  QString rowHtml( const Row& ) const;
+  bool setTotals( DocPositionBase::TaxType, double, double, const DocTotals& );
 
   DocGuardedPtr mDoc;
   QString mType;
@@ -65,6 +81,10 @@ private:
   QString mPositions;
   QString mGoodbye;
   QString mTotal;
+  QVector<Row> mRows;
+  QString mTotalsKey;
+  QString mTotalsHtml;
+  QString mDisplayedHtml;
   int mPositionCount;
   DisplayMode mMode;
   bool mShowPrices;
@@ -21,6 +21,9 @@
 #include "format.h"
 #include "kraftsettings.h"
 
+#include <QMetaProperty>
+#include <QLocale>
+
 #include <klocalizedstring.h>
 
 #define TAG( THE_TAG )  QStringLiteral( THE_TAG )
@@ -137,6 +140,52 @@ QVariantHash labelVariantHash()
     return hash;
 }
 
+/*
+ * The labels only depend on the translation and the locale, they are
+ * created once per combination.
+ */
+QVariantHash cachedLabelVariantHash()
+{
+    static QHash<QString, QVariantHash> labels;
+
+    const QString key = KLocalizedString::languages().join(QLatin1Char(':'))
+            + QLatin1Char('|') + DefaultProvider::self()->locale()->name();
+
+    auto it = labels.constFind(key);
+    if (it == labels.constEnd()) {
+        it = labels.insert(key, labelVariantHash());
+    }
+    return it.value();
+}
+
+/*
+ * The own identity is the same for all documents. Its hash is only
+ * created again if the identity changed.
+ */
+QVariantHash myContactVariantHash(const KContacts::Addressee& myContact)
+{
+    static KContacts::Addressee cachedContact;
+    static QVariantHash cachedHash;
+    static bool valid = false;
+
+    if (!valid || !(myContact == cachedContact)) {
+        cachedContact = myContact;
+        cachedHash = contactToVariantHash(myContact);
+        valid = true;
+    }
+    return cachedHash;
+}
+
+void registerGrantleeTypes()
+{
+    static bool registered = false;
+    if (!registered) {
+        Grantlee::registerMetaType<ArchDocPosition>();
+        Grantlee::registerMetaType<ArchDocPositionList>();
+        registered = true;
+    }
+}
+
 void variantHashToTemplate( TextTemplate& tmpl, const QString& prefix, const QVariantHash& hash)
 {
     QVariantHash::const_iterator i;
@@ -158,10 +207,136 @@ void contactToTemplate( TextTemplate& tmpl, const QString& prefix, const KContac
 
 void addLabelsToTemplate(TextTemplate& tmpl)
 {
-    const QVariantHash hash = labelVariantHash();
+    const QVariantHash hash = cachedLabelVariantHash();
     variantHashToTemplate(tmpl, QStringLiteral("LAB"), hash);
 }
 
+/*
+ * Property names of the render views. They are created once, so that the
+ * hashes of all views share the same key strings.
+ */
+struct RenderViewKeys
+{
+    const QString items         {QStringLiteral("items")};
+    const QString itemNumber    {QStringLiteral("itemNumber")};
+    const QString text          {QStringLiteral("text")};
+    const QString htmlText      {QStringLiteral("htmlText")};
+    const QString kind          {QStringLiteral("kind")};
+    const QString unit          {QStringLiteral("unit")};
+    const QString unitCode      {QStringLiteral("unitCode")};
+    const QString unitPrice     {QStringLiteral("unitPrice")};
+    const QString unitPriceNum  {QStringLiteral("unitPriceNum")};
+    const QString nettoPrice    {QStringLiteral("nettoPrice")};
+    const QString nettoPriceNum {QStringLiteral("nettoPriceNum")};
+    const QString amount        {QStringLiteral("amount")};
+    const QString amountNum     {QStringLiteral("amountNum")};
+    const QString taxType       {QStringLiteral("taxType")};
+    const QString itemType      {QStringLiteral("itemType")};
+    const QString taxMarker     {QStringLiteral("taxMarker")};
+
+    // the readable properties of ArchDoc, except the items
+    QVector<QPair<QMetaProperty, QString>> docProperties;
+
+    RenderViewKeys()
+    {
+        const QMetaObject& meta = ArchDoc::staticMetaObject;
+        for (int i = meta.propertyOffset(); i < meta.propertyCount(); i++) {
+            const QMetaProperty prop = meta.property(i);
+            const QString name = QString::fromLatin1(prop.name());
+            if (prop.isReadable() && name != items) {
+                docProperties.append(qMakePair(prop, name));
+            }
+        }
+    }
+};
+
+const RenderViewKeys& renderViewKeys()
+{
+    static const RenderViewKeys keys;
+    return keys;
+}
+
+QString taxTypeString(DocPositionBase::TaxType type)
+{
+    if (type == DocPositionBase::TaxType::TaxFull) {
+        return QStringLiteral("fullTax");
+    } else if (type == DocPositionBase::TaxType::TaxReduced) {
+        return QStringLiteral("reducedTax");
+    } else if (type == DocPositionBase::TaxType::TaxNone) {
+        return QStringLiteral("noTax");
+    }
+    return QStringLiteral("Invalid");
+}
+
+/*
+ * The values the ArchDocPosition Grantlee lookup returns, formatted once.
+ * unitCodes caches the unit code lookups of one render.
+ */
+QVariantHash positionRenderView(const ArchDocPosition& pos, const QLocale& locale,
+                                QHash<QString, QString>& unitCodes)
+{
+    const RenderViewKeys& k = renderViewKeys();
+
+    const QString unit = pos.unit();
+    auto unitCode = unitCodes.constFind(unit);
+    if (unitCode == unitCodes.constEnd()) {
+        unitCode = unitCodes.insert(unit, pos.unitEC20());
+    }
+
+    const Geld unitPrice = pos.unitPrice();
+    const Geld nettoPrice = pos.nettoPrice();
+    const double amount = pos.amount();
+
+    QVariantHash view;
+    view.reserve(16);
+    view.insert(k.itemNumber, pos.posNumber());
+    view.insert(k.text, pos.text());
+    view.insert(k.htmlText, pos.htmlText());
+    view.insert(k.kind, pos.kind());
+    view.insert(k.itemType, pos.kind());
+    view.insert(k.unit, unit);
+    view.insert(k.unitCode, unitCode.value());
+    view.insert(k.unitPrice, unitPrice.toLocaleString());
+    view.insert(k.unitPriceNum, QString::number(unitPrice.toDouble(), 'f', 2));
+    view.insert(k.nettoPrice, nettoPrice.toLocaleString());
+    view.insert(k.nettoPriceNum, QString::number(nettoPrice.toDouble(), 'f', 2));
+    view.insert(k.amount, locale.toString(amount));
+    view.insert(k.amountNum, QString::number(amount, 'f', 2));
+    view.insert(k.taxType, taxTypeString(pos.taxType()));
+    view.insert(k.taxMarker, pos.taxMarkerHelper());
+    return view;
+}
+
+/*
+ * Flattens the document with all its positions into plain values for
+ * the Grantlee templates, so that they do not go through the QObject
+ * and ArchDocPosition lookups and format the values again with every
+ * access.
+ */
+QVariantHash archDocRenderView(const ArchDoc *archDoc)
+{
+    const RenderViewKeys& k = renderViewKeys();
+
+    QVariantHash view;
+    view.reserve(k.docProperties.size() + 1);
+    for (const auto& prop : k.docProperties) {
+        view.insert(prop.second, prop.first.read(archDoc));
+    }
+
+    const QLocale locale = *DefaultProvider::self()->locale();
+    QHash<QString, QString> unitCodes;
+
+    const ArchDocPositionList positions = archDoc->positions();
+    QVariantList items;
+    items.reserve(positions.size());
+    for (const ArchDocPosition& pos : positions) {
+        items.append(positionRenderView(pos, locale, unitCodes));
+    }
+    view.insert(k.items, items);
+
+    return view;
+}
+
 }
 
 // ==================================================================================
@@ -302,7 +477,7 @@ const QString CTemplateDocumentTemplate::expand(ArchDoc *archDoc, const KContact
     tmpl.setValue( TAG( "ADDRESS" ), escapeTrml2pdfXML( archDoc->address() ) );
 
     contactToTemplate( tmpl, "CLIENT", customerContact );
-    contactToTemplate( tmpl, "MY", myContact );
+    variantHashToTemplate( tmpl, "MY", myContactVariantHash(myContact) );
 
     tmpl.setValue( TAG( "DOCID" ),   escapeTrml2pdfXML( archDoc->ident() ) );
     tmpl.setValue( TAG( "PROJECTLABEL" ),   escapeTrml2pdfXML( archDoc->projectLabel() ) );
@@ -356,8 +531,10 @@ const QString GrantleeDocumentTemplate::expand( ArchDoc *archDoc,
                                                const KContacts::Addressee &myContact,
                                                const KContacts::Addressee &customerContact)
 {
-    Grantlee::registerMetaType<ArchDocPosition>();
-    Grantlee::registerMetaType<ArchDocPositionList>();
+    registerGrantleeTypes();
+
+    // the template object can be used for more than one document
+    _errorStr.clear();
 
     QFileInfo fi(_tmplFile);
     if (!fi.exists()) {
@@ -372,11 +549,13 @@ const QString GrantleeDocumentTemplate::expand( ArchDoc *archDoc,
 
         GrantleeFileTemplate gtmpl(_tmplFile);
 
-        gtmpl.addToObjMapping("doc", archDoc);
+        if (archDoc) {
+            gtmpl.addToMapping(QStringLiteral("doc"), archDocRenderView(archDoc));
+        }
 
-        gtmpl.addToMapping(QStringLiteral("me"), contactToVariantHash(myContact));
+        gtmpl.addToMapping(QStringLiteral("me"), myContactVariantHash(myContact));
         gtmpl.addToMapping(QStringLiteral("customer"), contactToVariantHash(customerContact));
-        const QVariantHash labelHash = labelVariantHash();
+        const QVariantHash labelHash = cachedLabelVariantHash();
         gtmpl.addToMapping(QStringLiteral("label"), labelHash);
         bool ok;
         rendered = gtmpl.render(ok);
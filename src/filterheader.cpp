@@ -17,10 +17,14 @@
  ***************************************************************************/
 
 #include "filterheader.h"
+#include "kataloglistview.h"
 
 #include <klocalizedstring.h>
 #include <QDebug>
 #include <QTreeWidget>
+#include <QAbstractItemModel>
+
+#include <algorithm>
 
 #include <QLayout>
 #include <QLabel>
@@ -31,9 +35,36 @@
 #include <QVBoxLayout>
 #include <QLineEdit>
 
+namespace {
+
+// items are matched by the texts of all columns. The separator can not be
+// typed into the line edit, so that a match never spans two columns.
+const QChar ColumnSeparator(0x1F);
+
+QVector<int> intersect( const QVector<int>& a, const QVector<int>& b )
+{
+    QVector<int> re;
+    re.reserve( qMin(a.size(), b.size()) );
+    int i = 0, j = 0;
+    while( i < a.size() && j < b.size() ) {
+        if( a.at(i) < b.at(j) ) {
+            i++;
+        } else if( b.at(j) < a.at(i) ) {
+            j++;
+        } else {
+            re.append( a.at(i) );
+            i++; j++;
+        }
+    }
+    return re;
+}
+
+}
+
 FilterHeader::FilterHeader(QWidget *parent , QTreeWidget *listView)
   : QWidget( parent ),
-    _treeWidget(listView)
+    _treeWidget(nullptr),
+    _indexValid(false)
 {
     QBoxLayout *filterLayout = new QHBoxLayout;
     setLayout(filterLayout);
@@ -47,58 +78,216 @@ FilterHeader::FilterHeader(QWidget *parent , QTreeWidget *listView)
     connect( mSearchLine, SIGNAL(textChanged(QString) ),
              SLOT( slotTextChanged(QString) ) );
     filterLayout->addWidget( mSearchLine );
+
+    setListView( listView );
 }
 
-void FilterHeader::slotTextChanged( const QString& filter )
+QString FilterHeader::filterText() const
 {
-    if( ! _treeWidget ) {
-        return;
-    }
+    return mSearchLine->text();
+}
+
+void FilterHeader::setFilterText( const QString& filter )
+{
+    mSearchLine->setText( filter );
+}
+
+void FilterHeader::slotTreeChanged()
+{
+    _indexValid = false;
+}
+
+void FilterHeader::buildIndex()
+{
+    _items.clear();
+    _parents.clear();
+    _texts.clear();
+    _hidden.clear();
+    _trigrams.clear();
+    _lastFilter.clear();
+    _lastMatches.clear();
+
+    QHash<QTreeWidgetItem*, int> positions;
     QTreeWidgetItemIterator it(_treeWidget);
     while (*it) {
-        // items without parent are root items. Never hide.
         QTreeWidgetItem *item = (*it);
-        if( item->parent() ) {
-            bool showIt = false;
-            for(int i = 0; !showIt && i < item->columnCount(); i++) {
-                if( item->text(i).contains(filter, Qt::CaseInsensitive)) {
-                    showIt = true;
-                }
-            }
+        const int pos = _items.size();
+        positions.insert( item, pos );
+        _items.append( item );
+        // the parent always comes before its children
+        _parents.append( item->parent() ? positions.value( item->parent(), -1 ) : -1 );
+        _hidden.append( item->isHidden() );
 
-            item->setHidden(!showIt);
-            if( showIt && ! filter.isEmpty() ) {
-                // Make sure that all the parent items are visible too
-                QTreeWidgetItem *parent = nullptr, *child = item;
-                while((parent = child->parent()) != nullptr) {
-                    parent->setHidden(false);
-                    if( !parent->isExpanded() ) {
-                        parent->setExpanded(true);
-                        _openedItems[parent] = 1;
-                    }
-                    child = parent;
-                }
-            }
-            if (filter.isEmpty()) {
-                for( auto item : _openedItems.uniqueKeys()) {
-                    item->setExpanded(false);
-                }
-                _openedItems.clear();
+        QString text;
+        for(int i = 0; i < item->columnCount(); i++) {
+            if( i > 0 ) text += ColumnSeparator;
+            text += item->text(i).toLower();
+        }
+        for( int i = 0; i + 3 <= text.size(); i++ ) {
+            QVector<int>& list = _trigrams[text.mid(i, 3)];
+            if( list.isEmpty() || list.last() != pos ) {
+                list.append( pos );
             }
         }
+        _texts.append( text );
         ++it;
     }
+
+    // the items might be gone that were expanded by the previous filter
+    QMutableHashIterator<QTreeWidgetItem*, int> opened(_openedItems);
+    while( opened.hasNext() ) {
+        opened.next();
+        if( !positions.contains( opened.key() ) ) {
+            opened.remove();
+        }
+    }
+    _indexValid = true;
+}
+
+/*
+ * The items that might match the filter: the previous matches if the
+ * filter extends the previous one, otherwise the items that contain all
+ * trigrams of the filter. Short filters check all items.
+ */
+QVector<int> FilterHeader::candidates( const QString& filter ) const
+{
+    if( !_lastFilter.isEmpty() && filter.contains(_lastFilter) ) {
+        return _lastMatches;
+    }
+
+    QVector<int> re;
+    if( filter.size() < 3 ) {
+        re.reserve( _items.size() );
+        for( int i = 0; i < _items.size(); i++ ) {
+            re.append(i);
+        }
+        return re;
+    }
+
+    // intersect starting with the shortest list
+    QVector<const QVector<int>*> lists;
+    for( int i = 0; i + 3 <= filter.size(); i++ ) {
+        auto list = _trigrams.constFind( filter.mid(i, 3) );
+        if( list == _trigrams.constEnd() ) {
+            return re;
+        }
+        lists.append( &list.value() );
+    }
+    std::sort( lists.begin(), lists.end(), []( const QVector<int>* a, const QVector<int>* b ) {
+        return a->size() < b->size();
+    });
+    re = *lists.first();
+    for( int i = 1; i < lists.size() && !re.isEmpty(); i++ ) {
+        re = intersect( re, *lists.at(i) );
+    }
+    return re;
+}
+
+void FilterHeader::applyMatches( const QVector<int>& matches )
+{
+    QVector<bool> show( _items.size(), false );
+    QVector<bool> expand( _items.size(), false );
+    for( int pos : matches ) {
+        show[pos] = true;
+        // Make sure that all the parent items are visible and open too
+        for( int p = _parents.at(pos); p >= 0 && !expand.at(p); p = _parents.at(p) ) {
+            show[p] = true;
+            expand[p] = true;
+        }
+    }
+
+    for( int i = 0; i < _items.size(); i++ ) {
+        QTreeWidgetItem *item = _items.at(i);
+        // items without parent are root items. Never hide.
+        if( !item->parent() ) {
+            continue;
+        }
+        if( _hidden.at(i) == show.at(i) ) {
+            item->setHidden( !show.at(i) );
+            _hidden[i] = !show.at(i);
+        }
+    }
+    for( int i = 0; i < _items.size(); i++ ) {
+        QTreeWidgetItem *item = _items.at(i);
+        if( expand.at(i) && !item->isExpanded() ) {
+            item->setExpanded(true);
+            _openedItems[item] = 1;
+        }
+    }
+}
+
+void FilterHeader::showAll()
+{
+    for( int i = 0; i < _items.size(); i++ ) {
+        if( _hidden.at(i) ) {
+            _items.at(i)->setHidden(false);
+            _hidden[i] = false;
+        }
+    }
+    for( auto item : _openedItems.uniqueKeys()) {
+        item->setExpanded(false);
+    }
+    _openedItems.clear();
+}
+
+void FilterHeader::slotTextChanged( const QString& filter )
+{
+    if( ! _treeWidget ) {
+        return;
+    }
+    // chapters that were never expanded do not have their items yet
+    KatalogListView *katalogView = qobject_cast<KatalogListView*>( _treeWidget );
+    if( katalogView && !filter.isEmpty() ) {
+        katalogView->populateAllChapters();
+    }
+    if( !_indexValid ) {
+        buildIndex();
+    }
+
+    const bool updates = _treeWidget->updatesEnabled();
+    _treeWidget->setUpdatesEnabled(false);
+
+    const QString f = filter.toLower();
+    if( f.isEmpty() ) {
+        showAll();
+        _lastMatches.clear();
+    } else {
+        const QVector<int> cands = candidates( f );
+        QVector<int> matches;
+        for( int pos : cands ) {
+            if( _texts.at(pos).contains(f) ) {
+                matches.append(pos);
+            }
+        }
+        applyMatches( matches );
+        _lastMatches = matches;
+    }
+    _lastFilter = f;
+
+    _treeWidget->setUpdatesEnabled(updates);
 }
 
 void FilterHeader::setListView( QTreeWidget* view )
 {
+    if( _treeWidget ) {
+        disconnect( _treeWidget->model(), nullptr, this, nullptr );
+    }
     _treeWidget = view;
+    _indexValid = false;
+    _openedItems.clear();
+
+    if( _treeWidget ) {
+        QAbstractItemModel *model = _treeWidget->model();
+        connect( model, &QAbstractItemModel::rowsInserted, this, &FilterHeader::slotTreeChanged );
+        connect( model, &QAbstractItemModel::rowsRemoved, this, &FilterHeader::slotTreeChanged );
+        connect( model, &QAbstractItemModel::rowsMoved, this, &FilterHeader::slotTreeChanged );
+        connect( model, &QAbstractItemModel::dataChanged, this, &FilterHeader::slotTreeChanged );
+        connect( model, &QAbstractItemModel::modelReset, this, &FilterHeader::slotTreeChanged );
+        connect( model, &QAbstractItemModel::layoutChanged, this, &FilterHeader::slotTreeChanged );
+    }
 }
 
 void FilterHeader::clear()
 {
     mSearchLine->clear();
 }
-
-
-
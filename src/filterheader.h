@@ -22,6 +22,8 @@
 #include <QWidget>
 #include <QLineEdit>
 #include <QTreeWidgetItem>
+#include <QHash>
+#include <QVector>
 
 #include "kraftcat_export.h"
 
@@ -30,24 +32,54 @@ class QLabel;
 class QString;
 
 
+/*
+ * Filters the items of a tree widget by the text typed into a line edit.
+ *
+ * The lower case texts of all items are indexed by their trigrams when
+ * the first filter is set, and again after the tree has changed. A query
+ * only checks the items that contain all of its trigrams, and a query that
+ * extends the previous one only checks the previous matches. The visibility
+ * is changed only for items where it differs, with the view updates
+ * disabled meanwhile.
+ */
 class KRAFTCAT_EXPORT FilterHeader : public QWidget
 {
     Q_OBJECT
   public:
     FilterHeader(QWidget *parent = 0, QTreeWidget *tree = 0);
 
+    QString filterText() const;
+
   public slots:
     void clear();
     void setListView( QTreeWidget* );
+    void setFilterText( const QString& filter );
 
 private slots:
     void slotTextChanged( const QString& filter );
+    void slotTreeChanged();
 
   private:
+    void buildIndex();
+    QVector<int> candidates( const QString& filter ) const;
+    void applyMatches( const QVector<int>& matches );
+    void showAll();
+
     QLineEdit   *mSearchLine;
     QLabel      *mTitleLabel;
     QTreeWidget *_treeWidget;
     QHash<QTreeWidgetItem*, int> _openedItems;
+
+    // the index, positions are the item positions in the tree
+    bool _indexValid;
+    QVector<QTreeWidgetItem*> _items;
+    QVector<int> _parents;
+    QVector<QString> _texts;
+    QVector<bool> _hidden;
+    QHash<QString, QVector<int> > _trigrams;
+
+    QString _lastFilter;
+    QVector<int> _lastMatches;
 };
 
 #endif
@@ -29,6 +29,7 @@
 #include "fixcalcpart.h"
 #include "timecalcpart.h"
 #include "stockmaterial.h"
+#include "templkatalog.h"
 
 
 FloskelTemplate::FloskelTemplate()
@@ -36,6 +37,8 @@ FloskelTemplate::FloskelTemplate()
       mTemplId(-1),
       m_chapter(0),
       mTimeAdd(true),
+      mCalcPartsLoaded(true),
+      mHasStoredPrice(false),
       m_listViewItem(0),
       m_saver(0)
 {
@@ -48,6 +51,8 @@ FloskelTemplate::FloskelTemplate( int tID, const QString& text,
    mTemplId(tID),
    m_chapter(chapter),
    mTimeAdd(true),
+   mCalcPartsLoaded(false),
+   mHasStoredPrice(false),
    m_preis(long(0)),
    m_listViewItem(0),
    m_saver(0)
@@ -68,6 +73,9 @@ FloskelTemplate::FloskelTemplate( int tID, const QString& text,
 FloskelTemplate::FloskelTemplate( FloskelTemplate& templ )
     : CatalogTemplate( templ ),
       mTemplId( templ.mTemplId ),
+      mCalcPartsLoaded( true ),
+      mHasStoredPrice( templ.mHasStoredPrice ),
+      m_storedPrice( templ.m_storedPrice ),
       m_preis( templ.m_preis ),
       m_listViewItem(templ.m_listViewItem ),
       m_saver( 0 )
@@ -89,6 +97,8 @@ FloskelTemplate& FloskelTemplate::operator= ( FloskelTemplate& src )
   mTemplId = src.mTemplId;
   mChapterId = src.mChapterId;
   m_preis = src.m_preis;
+  mHasStoredPrice = src.mHasStoredPrice;
+  m_storedPrice = src.m_storedPrice;
   m_listViewItem = src.m_listViewItem;
   m_saver = 0; // src.m_saver;
 
@@ -106,7 +116,9 @@ void FloskelTemplate::deepCopyCalcParts( FloskelTemplate& templ )
 {
   CalcPart *cp = 0;
 
+  templ.loadCalcParts();
   m_calcParts.clear();
+  mCalcPartsLoaded = true;
 
   QListIterator<CalcPart*> i( templ.m_calcParts );
   while( i.hasNext()) {
@@ -131,6 +143,7 @@ void FloskelTemplate::setBenefit( double g )
     /* Every calc part has an value for benefit. Set the benefit value for
        each calc part, later on each can have its own value
      */
+    loadCalcParts();
     for( auto *cp: m_calcParts) {
         cp->setProzentPlus(g);
     }
@@ -141,6 +154,7 @@ double FloskelTemplate::getBenefit( )
     bool first = true;
     double b = 0.0;
 
+    loadCalcParts();
     for( auto *cp: m_calcParts) {
         if( first ) {
             b = cp->getProzentPlus();
@@ -159,9 +173,35 @@ void FloskelTemplate::setTemplID( int newID )
 
 Geld FloskelTemplate::unitPrice()
 {
+  // as long as nobody needs the calculation parts, the stored price does
+  if( calcKind() != ManualPrice && !mCalcPartsLoaded && mHasStoredPrice ) {
+    return m_storedPrice;
+  }
   return calcPreis();
 }
 
+void FloskelTemplate::setStoredPrice( const Geld& g )
+{
+  m_storedPrice = g;
+  mHasStoredPrice = true;
+}
+
+void FloskelTemplate::clearStoredPrice()
+{
+  mHasStoredPrice = false;
+}
+
+void FloskelTemplate::loadCalcParts()
+{
+  if( mCalcPartsLoaded ) {
+    return;
+  }
+  mCalcPartsLoaded = true;
+  if( mTemplId > 0 ) {
+    TemplKatalog::loadCalcParts( this );
+  }
+}
+
 
 Geld FloskelTemplate::calcPreis()
 {
@@ -170,6 +210,7 @@ Geld FloskelTemplate::calcPreis()
     if( calcKind() == ManualPrice ) {
         g = m_preis;
     } else {
+        loadCalcParts();
         g = m_calcParts.calcPrice();
        double b = getBenefit();
        g += g.percent(b);
@@ -187,16 +228,19 @@ CalcPartList FloskelTemplate::getCalcPartsList()
 // from template -> document calculations.
 CalcPartList FloskelTemplate::decoupledCalcPartsList()
 {
+  loadCalcParts();
   return m_calcParts.decoupledCalcPartsList();
 }
 
 CalcPartList FloskelTemplate::getCalcPartsList( const QString& calcPart )
 {
+  loadCalcParts();
   return m_calcParts.getCalcPartsList( calcPart );
 }
 
 void FloskelTemplate::addCalcPart( CalcPart* cpart )
 {
+    loadCalcParts();
     m_calcParts.append(cpart);
 }
 
@@ -217,10 +261,13 @@ void FloskelTemplate::clearCalcParts()
   }
 
   m_calcParts.clear();
+  // empty now, nothing left to load
+  mCalcPartsLoaded = true;
 }
 
 Geld FloskelTemplate::costsByCalcPart( const QString& part )
 {
+  loadCalcParts();
   return m_calcParts.costPerCalcPart( part );
 }
 
@@ -52,6 +52,23 @@ public:
     Geld unitPrice();
     Geld costsByCalcPart( const QString& part);
 
+    /**
+     * The unit price as computed from the calculation parts and stored
+     * in the catalog. unitPrice() returns it as long as the calculation
+     * parts are not loaded.
+     */
+    void setStoredPrice( const Geld& g );
+    Geld storedPrice() const { return m_storedPrice; }
+    bool hasStoredPrice() const { return mHasStoredPrice; }
+    void clearStoredPrice();
+
+    /**
+     * Templates from the catalog load their calculation parts on first
+     * use. All methods that work with the parts call this.
+     */
+    void loadCalcParts();
+    bool calcPartsLoaded() const { return mCalcPartsLoaded; }
+
     void addCalcPart( CalcPart* cpart );
     void removeCalcPart( CalcPart *cpart );
     void clearCalcParts();
@@ -93,6 +110,9 @@ private: // Private methods
     int              m_chapter;
     CalcPartList     m_calcParts;
     bool             mTimeAdd;
+    bool             mCalcPartsLoaded;
+    bool             mHasStoredPrice;
+    Geld             m_storedPrice;
     Geld             m_preis; // preis only valid for manual calculation.
     QTreeWidgetItem  *m_listViewItem;
     TemplateSaverBase *m_saver;    /**  */
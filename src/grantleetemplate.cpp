@@ -21,6 +21,9 @@
 #include <QDebug>
 
 #include <QFileInfo>
+#include <QDateTime>
+#include <QDirIterator>
+#include <QThreadStorage>
 #include <string.h>
 
 #include <grantlee/engine.h>
@@ -28,6 +31,83 @@
 #include <grantlee/template.h>
 #include <grantlee/templateloader.h>
 
+namespace {
+
+/*
+ * The templates pulled in with extends or include are compiled into the
+ * template, but are not known here. So the newest modification time and
+ * the amount of all files below the template directory are compared.
+ */
+struct DirStamp {
+    QDateTime newest;
+    int files = 0;
+
+    bool operator==(const DirStamp& other) const {
+        return newest == other.newest && files == other.files;
+    }
+};
+
+DirStamp dirStamp(const QString& dir)
+{
+    DirStamp stamp;
+    // renaming or removing a file changes the directory
+    stamp.newest = QFileInfo(dir).lastModified();
+
+    QDirIterator it(dir, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        it.next();
+        const QDateTime modified = it.fileInfo().lastModified();
+        if (modified > stamp.newest) {
+            stamp.newest = modified;
+        }
+        stamp.files++;
+    }
+    return stamp;
+}
+
+struct CachedTemplate {
+    Grantlee::Template tmpl;
+    DirStamp stamp;
+};
+
+struct EngineCache {
+    ~EngineCache() {
+        // the templates refer to their engine
+        templates.clear();
+        qDeleteAll(engines);
+    }
+
+    // one engine per template directory, as the loader looks up includes there
+    QHash<QString, Grantlee::Engine*> engines;
+    // compiled templates by absolute file name
+    QHash<QString, CachedTemplate> templates;
+};
+
+QThreadStorage<EngineCache*> _engineCache;
+
+EngineCache *engineCache()
+{
+    if (!_engineCache.hasLocalData()) {
+        _engineCache.setLocalData(new EngineCache);
+    }
+    return _engineCache.localData();
+}
+
+Grantlee::Engine *engineForDir(EngineCache *cache, const QString& dir)
+{
+    Grantlee::Engine *engine = cache->engines.value(dir);
+    if (!engine) {
+        engine = new Grantlee::Engine();
+        auto loader = QSharedPointer<Grantlee::FileSystemTemplateLoader>::create();
+        loader->setTemplateDirs( {dir} );
+        engine->addTemplateLoader( loader );
+        cache->engines.insert(dir, engine);
+    }
+    return engine;
+}
+
+}
+
 GrantleeFileTemplate::GrantleeFileTemplate( const QString& file)
     :_tmplFileName(file)
 {
@@ -43,22 +123,49 @@ void GrantleeFileTemplate::addToObjMapping(const QString& key, QObject *obj)
     _objs.insert(key, obj);
 }
 
-QString GrantleeFileTemplate::render(bool &ok) const
+void GrantleeFileTemplate::clearCache()
 {
-    QScopedPointer<Grantlee::Engine> engine(new Grantlee::Engine());
+    if (_engineCache.hasLocalData()) {
+        // deletes the old cache
+        _engineCache.setLocalData(nullptr);
+    }
+}
 
+Grantlee::Template GrantleeFileTemplate::compiledTemplate(QString& error) const
+{
     QFileInfo fi(_tmplFileName);
-    ok = true; // assume all goes well.
+    const QString path = fi.absoluteFilePath();
+    const DirStamp stamp = dirStamp(fi.absolutePath());
 
-    auto loader = QSharedPointer<Grantlee::FileSystemTemplateLoader>::create();
-    loader->setTemplateDirs( {fi.absolutePath()} );
-    engine->addTemplateLoader( loader );
+    EngineCache *cache = engineCache();
+    auto it = cache->templates.constFind(path);
+    if (it != cache->templates.constEnd() && it->stamp == stamp) {
+        return it->tmpl;
+    }
 
-    QString output;
+    Grantlee::Engine *engine = engineForDir(cache, fi.absolutePath());
     auto t = engine->loadByName(fi.fileName());
     if (t->error() != Grantlee::Error::NoError) {
+        error = t->errorString();
+        cache->templates.remove(path);
+        return Grantlee::Template();
+    }
+
+    CachedTemplate ct;
+    ct.tmpl = t;
+    ct.stamp = stamp;
+    cache->templates.insert(path, ct);
+    return t;
+}
+
+QString GrantleeFileTemplate::render(bool &ok) const
+{
+    ok = true; // assume all goes well.
+
+    QString output;
+    auto t = compiledTemplate(output);
+    if (!t) {
         ok = false;
-        output = t->errorString();
         qDebug() << "Grantlee template load failed:" << output;
     }
 
@@ -84,7 +191,3 @@ QString GrantleeFileTemplate::render(bool &ok) const
 
     return output;
 }
-
-
-
-
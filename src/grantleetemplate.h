@@ -25,6 +25,14 @@
 #include <grantlee/engine.h>
 #include <grantlee/template.h>
 
+/**
+ * Renders a Grantlee template file.
+ *
+ * The Grantlee engines, one per thread and template directory, and the
+ * compiled templates are cached. A template is compiled again if any
+ * file in its directory changed, as the templates it extends or
+ * includes are compiled into it.
+ */
 class GrantleeFileTemplate
 {
 public:
@@ -35,9 +43,14 @@ public:
 
     QString render(bool& ok) const;
 
+    // drops the engines and compiled templates of the calling thread
+    static void clearCache();
+
 private:
+    Grantlee::Template compiledTemplate(QString& error) const;
+
     QVariantHash _mapping;
-    const QString& _tmplFileName;
+    const QString _tmplFileName;
     QHash<QString, QObject*> _objs;
 };
 
@@ -50,6 +50,8 @@ void HtmlView::setStylesheetFile( const QString &style )
         qDebug() << "Unable to find stylesheet file "<< style;
         mStyles.clear();
     }
+    // set once here instead of with every content
+    this->document()->setDefaultStyleSheet(mStyles);
 }
 
 void HtmlView::zoomIn()
@@ -129,7 +131,6 @@ void HtmlView::displayContent( const QString& content )
     }
 
     const QString out = topFrame() + content + bottomFrame();
-    const QString s = mStyles;
 
 #ifdef QT_DEBUG
     // this file gets written and removed immediately, so if it should be kept,
@@ -141,14 +142,13 @@ void HtmlView::displayContent( const QString& content )
         qDebug() << "########## HtmlView output written to" << fName;
 
         QTextStream outStream(&tempFile);
-        outStream << s;
+        outStream << mStyles;
         outStream << "##############" << endl;
         outStream << out;
         tempFile.close();
     }
 #endif
 
-    this->document()->setDefaultStyleSheet(s);
     setHtml(out);
 }
 
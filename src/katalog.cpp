@@ -17,11 +17,14 @@
 
 #include <qdom.h>
 #include <QSqlQuery>
+#include <QSqlDatabase>
+#include <QSqlError>
 #include <QDebug>
 
 #include "floskeltemplate.h"
 #include "dbids.h"
 #include "katalog.h"
+#include "katalogman.h"
 #include "kraftdb.h"
 #include "unitmanager.h"
 #include "timecalcpart.h"
@@ -88,6 +91,10 @@ int Katalog::load()
     m_description = q.value(1).toString();
     // qDebug () << "Setting catalogSetID=" <<  m_setID << " from name " << m_name << endl;
   }
+
+  // the usage counts are read again by the catalogs
+  flushUsage();
+  mUsage.clear();
   return 0;
 }
 
@@ -96,6 +103,8 @@ QList<CatalogChapter> Katalog::getKatalogChapters( bool freshup )
   if( mChapters.empty() || freshup || mChapterListNeedsRefresh ) {
 
     mChapters.clear();
+    mChapterPosById.clear();
+    mChapterPosByName.clear();
 
     //    CREATE TABLE CatalogChapters(
     //            chapterID INTEGER PRIMARY KEY ASC autoincrement,
@@ -104,7 +113,7 @@ QList<CatalogChapter> Katalog::getKatalogChapters( bool freshup )
     //            sortKey      INT NOT NULL
     //    );
     QSqlQuery q;
-    q.prepare("SELECT chapterID, chapter, parentChapter, description FROM CatalogChapters WHERE "
+    q.prepare("SELECT chapterID, chapter, parentChapter, description, sortKey FROM CatalogChapters WHERE "
               "catalogSetId = :catalogSetId ORDER BY parentChapter, sortKey");
     q.bindValue(":catalogSetId", m_setID);
     q.exec();
@@ -119,6 +128,12 @@ QList<CatalogChapter> Katalog::getKatalogChapters( bool freshup )
 
       // qDebug () << "Adding catalog chapter " << chapterName << " with ID " << chapID << endl;
       CatalogChapter c( chapID, m_setID, chapterName, parentChapter, desc );
+      c.setSortKey( q.value(4).toInt() );
+      mChapterPosById.insert( chapID, mChapters.size() );
+      // the first chapter of a name wins, same as with a scan
+      if( !mChapterPosByName.contains( chapterName ) ) {
+        mChapterPosByName.insert( chapterName, mChapters.size() );
+      }
       mChapters.append( c );
     }
     mChapterListNeedsRefresh = false;
@@ -129,22 +144,20 @@ QList<CatalogChapter> Katalog::getKatalogChapters( bool freshup )
 
 QString Katalog::chapterName(const dbID& id)
 {
-  foreach( CatalogChapter chapter, mChapters ) {
-    if( chapter.id() == id ) {
-      return chapter.name();
-    }
+  const int pos = mChapterPosById.value( dbID(id).toInt(), -1 );
+  if( pos > -1 ) {
+    return mChapters.at( pos ).name();
   }
   return i18n("not found");
 }
 
 dbID Katalog::chapterID( const QString& name )
 {
-    foreach( CatalogChapter chapter, mChapters ) {
-      if( chapter.name() == name ) {
-        return chapter.id();
-      }
-    }
-    return dbID();
+  const int pos = mChapterPosByName.value( name, -1 );
+  if( pos > -1 ) {
+    return mChapters.at( pos ).id();
+  }
+  return dbID();
 }
 
 QString Katalog::getName() const
@@ -196,6 +209,11 @@ int Katalog::chapterSortKey( const QString& chap )
 
 QPair<int, QDateTime> Katalog::usageCount(int id)
 {
+    auto known = mUsage.constFind(id);
+    if (known != mUsage.constEnd()) {
+        return known.value();
+    }
+
     QSqlQuery q;
     q.prepare("SELECT usageCount, lastUsed FROM catItemUsage WHERE catId=:catId AND itemId=:itemId");
     q.bindValue(":catId", this->id().toInt());
@@ -213,32 +231,75 @@ QPair<int, QDateTime> Katalog::usageCount(int id)
 
 QPair<int, QDateTime> Katalog::recordUsage(int id)
 {
-    QSqlQuery q;
     const QDateTime dt { QDateTime::currentDateTime() };
-    const QString ts { dt.toString("yyyy-MM-ddThh:mm:ss") };
-    int catId = this->id().toInt();
 
-    int usage = usageCount(id).first;
+    QPair<int, QDateTime> usage = usageCount(id);
+    usage.first += 1;
+    usage.second = dt;
+    mUsage.insert(id, usage);
+
+    QPair<int, QDateTime>& pending = mPendingUsage[id];
+    pending.first += 1;
+    pending.second = dt;
+
+    KatalogMan::self()->scheduleUsageFlush();
+    return usage;
+}
+
+/*
+ * The buffered usages are added to the stored counts, so that the counts
+ * of another Kraft on the same database are not overwritten.
+ */
+bool Katalog::flushUsage()
+{
+    if (mPendingUsage.isEmpty()) {
+        return true;
+    }
 
-    if (usage == 0) {
-        q.prepare("INSERT INTO catItemUsage SET catId=:catId, itemId=:itemId, usageCount=:usage, lastUsed=:timeStamp");
+    QSqlQuery q;
+    if (KraftDB::self()->isSqlite()) {
+        q.prepare("INSERT INTO catItemUsage (catId, itemId, usageCount, lastUsed) "
+                  "VALUES (:catId, :itemId, :usage, :timeStamp) "
+                  "ON CONFLICT(catId, itemId) DO UPDATE SET "
+                  "usageCount=usageCount+excluded.usageCount, lastUsed=excluded.lastUsed");
     } else {
-        q.prepare("UPDATE catItemUsage SET usageCount=:usage, lastUsed=:timeStamp WHERE catId=:catId AND itemId=:itemId");
+        q.prepare("INSERT INTO catItemUsage (catId, itemId, usageCount, lastUsed) "
+                  "VALUES (:catId, :itemId, :usage, :timeStamp) "
+                  "ON DUPLICATE KEY UPDATE "
+                  "usageCount=usageCount+VALUES(usageCount), lastUsed=VALUES(lastUsed)");
     }
-    usage += 1;
-    q.bindValue(":usage", usage);
-    q.bindValue(":catId", catId);
-    q.bindValue(":itemId", id);
-    q.bindValue(":timeStamp", ts);
 
-    if (!q.exec())
-        qDebug() << q.executedQuery() << q.lastError();
+    const int catId = this->id().toInt();
+    bool ok = true;
+    QSqlDatabase::database().transaction();
+    QHashIterator<int, QPair<int, QDateTime> > it(mPendingUsage);
+    while (ok && it.hasNext()) {
+        it.next();
+        q.bindValue(":catId", catId);
+        q.bindValue(":itemId", it.key());
+        q.bindValue(":usage", it.value().first);
+        q.bindValue(":timeStamp", it.value().second.toString("yyyy-MM-ddThh:mm:ss"));
+        if (!q.exec()) {
+            qDebug() << q.executedQuery() << q.lastError();
+            ok = false;
+        }
+    }
 
-    return QPair<int, QDateTime>(usage, dt);
+    if (ok) {
+        QSqlDatabase::database().commit();
+        mPendingUsage.clear();
+    } else {
+        // keep the usages for the next try
+        QSqlDatabase::database().rollback();
+    }
+    return ok;
 }
 
 void Katalog::deleteUsageRecord(int id)
 {
+    mUsage.remove(id);
+    mPendingUsage.remove(id);
+
     QSqlQuery q;
     q.prepare("DELETE FROM catItemUsage WHERE catId=:catId AND itemId=:itemId");
     q.bindValue(":catId", this->id().toInt());
@@ -20,6 +20,7 @@
 
 #include <kraftcat_export.h>
 
+#include <QHash>
 #include <QStringList>
 
 #include "floskeltemplate.h"
@@ -87,10 +88,22 @@ public:
     virtual QDomDocument toXML();
     virtual void writeXMLFile();
 
+    /** to be called after items of the catalog moved to another chapter */
+    virtual void invalidateChapterIndex() {}
+
     virtual QPair<int, QDateTime> usageCount(int id);
 
+    /**
+     * counts one more usage of the item. The new count is returned right
+     * away, the database is updated by flushUsage, which is scheduled
+     * through the KatalogMan.
+     */
     virtual QPair<int, QDateTime> recordUsage(int id);
 
+    /** write the buffered usages in one transaction */
+    bool flushUsage();
+    bool hasPendingUsage() const { return !mPendingUsage.isEmpty(); }
+
     dbID id();
 
     QLocale *locale() { return mLocale; }
@@ -98,7 +111,15 @@ public:
 protected:
     void deleteUsageRecord(int id);
 
+    // the known usage counts, including the ones not yet written
+    QHash<int, QPair<int, QDateTime> > mUsage;
+    // the usages that are not yet written to the database
+    QHash<int, QPair<int, QDateTime> > mPendingUsage;
+
     QList<CatalogChapter> mChapters;
+    // chapter id and name to the position in mChapters
+    QHash<int, int> mChapterPosById;
+    QHash<QString, int> mChapterPosByName;
     QString     m_name;
     QString     m_description;
     int         m_setID;
@@ -18,6 +18,11 @@
 #include <QtCore>
 #include <QtGui>
 #include <QMessageBox>
+#include <QSqlDatabase>
+#include <QSqlError>
+
+#include <algorithm>
+#include <limits>
 
 #include <klocalizedstring.h>
 
@@ -70,6 +75,7 @@ KatalogListView::KatalogListView( QWidget *parent ) : QTreeWidget(parent),
 
     connect( this, SIGNAL(itemActivated( QTreeWidgetItem*,int )),
              this, SLOT( slotItemEntered( QTreeWidgetItem*, int )));
+    connect( this, &QTreeWidget::itemExpanded, this, &KatalogListView::slotItemExpanded );
 }
 
 KatalogListView::~KatalogListView()
@@ -116,6 +122,7 @@ void KatalogListView::setupChapters()
         delete m_root;
         mChapterDict.clear();
     }
+    mLazyChapters.clear();
 
     // qDebug () << "Creating root item!" <<  endl;
     QStringList list;
@@ -134,32 +141,24 @@ void KatalogListView::setupChapters()
     const QList<CatalogChapter> chapters = cat->getKatalogChapters( true );
     // qDebug () << "Have count of chapters: " << chapters.size() << endl;
 
-    QList<CatalogChapter> strayCats;
-
-    foreach( CatalogChapter chapter, chapters ) {
-        QTreeWidgetItem *item = tryAddingCatalogChapter( chapter );
-        if( ! item ) {
-            strayCats.append( chapter );
-        } else {
-            // qDebug () << "Creating katalog chapter item for " << chapter.name() << endl;
-        }
+    // the children of every chapter, in the sort order of the catalog
+    QHash<int, QList<CatalogChapter> > children;
+    for( const CatalogChapter& chapter : chapters ) {
+        children[chapter.parentId().toInt()].append( chapter );
     }
 
-    int oldStrayCatCount = strayCats.count() + 1; // to survive the first while condition
-    while( strayCats.count() && strayCats.count() < oldStrayCatCount ) {
-        QList<CatalogChapter> newStrayCats;
-        oldStrayCatCount = strayCats.count();
-        // loop as long as the overall number of straycats goes down in every round
-        foreach( CatalogChapter chapter, strayCats ) {
-            QTreeWidgetItem *katItem = tryAddingCatalogChapter( chapter );
-            if( katItem ) {
-                // qDebug () << "Successfully added catalog chapter from strayCats";
-            } else {
-                newStrayCats.append( chapter );
-                // qDebug () << "Failed to add a catalog chapter from stryCats";
+    // top down from the root, so that every parent item exists before
+    // its children are added. Chapters whose parent does not exist are
+    // never reached and not shown.
+    QList<int> parents;
+    parents.append( 0 );
+    while( !parents.isEmpty() ) {
+        const int parentId = parents.takeFirst();
+        for( const CatalogChapter& chapter : children.value( parentId ) ) {
+            if( tryAddingCatalogChapter( chapter ) ) {
+                parents.append( chapter.id().toInt() );
             }
         }
-        strayCats = newStrayCats;
     }
 }
 
@@ -194,6 +193,40 @@ QTreeWidgetItem *KatalogListView::tryAddingCatalogChapter( const CatalogChapter&
     return katItem;
 }
 
+void KatalogListView::setChapterLazy( QTreeWidgetItem *item )
+{
+    if( item ) {
+        mLazyChapters.insert( item );
+        item->setChildIndicatorPolicy( QTreeWidgetItem::ShowIndicator );
+    }
+}
+
+void KatalogListView::populateChapter( QTreeWidgetItem *item )
+{
+    if( !item || !mLazyChapters.remove( item ) ) {
+        return;
+    }
+    item->setChildIndicatorPolicy( QTreeWidgetItem::DontShowIndicatorWhenChildless );
+
+    CatalogChapter *chap = static_cast<CatalogChapter*>( itemData( item ) );
+    if( chap ) {
+        addChapterItems( item, chap->id().toInt() );
+    }
+}
+
+void KatalogListView::populateAllChapters()
+{
+    const QList<QTreeWidgetItem*> lazy = mLazyChapters.values();
+    for( QTreeWidgetItem *item : lazy ) {
+        populateChapter( item );
+    }
+}
+
+void KatalogListView::slotItemExpanded( QTreeWidgetItem *item )
+{
+    populateChapter( item );
+}
+
 CatalogTemplateList KatalogListView::selectedTemplates()
 {
     CatalogTemplateList templates;
@@ -220,6 +253,7 @@ CatalogTemplateList KatalogListView::selectedTemplates()
         foreach( QTreeWidgetItem* item, items ) {
             if( isChapter(item) && !isRoot(item) ) {
                 // for chapters, the children are lined up.
+                populateChapter( item );
                 int kidCnt = item->childCount();
                 for( int i=0; i < kidCnt; i++ ) {
                     QTreeWidgetItem *kid = item->child(i);
@@ -282,6 +316,7 @@ void KatalogListView::removeTemplateItem( QTreeWidgetItem *item )
                 break;
             }
         }
+        mLazyChapters.remove( item );
     } else {
         m_dataDict.remove( item );
     }
@@ -350,6 +385,8 @@ void KatalogListView::slotRemoveCurrentChapter()
         // qDebug () << "Can only remove chapters here!" << endl;
     }
 
+    // the templates of a chapter that was never expanded count as well
+    populateChapter( item );
     if( item->childCount() > 0 ) {
         QMessageBox msgBox;
         msgBox.setText(i18n( "A catalog chapter can not be deleted as long it has children." ));
@@ -364,6 +401,7 @@ void KatalogListView::slotRemoveCurrentChapter()
         if( chap ) {
             int id = chap->id().toInt();
             if( chap->removeFromDB() ) {
+                mLazyChapters.remove( item );
                 delete item;
                 mChapterDict.remove(id);
                 delete chap;
@@ -508,6 +546,9 @@ void KatalogListView::dropEvent( QDropEvent *event )
             }
 
             if( parent ) {
+                // before the chapter of the moved template changes, otherwise
+                // the chapter would add the template a second time
+                populateChapter( parent );
                 QTreeWidgetItem *movedItem = taken.takeFirst();
                 if( newParentId.isOk() ) {
                     if( isChapter( movedItem ) )   {
@@ -527,6 +568,9 @@ void KatalogListView::dropEvent( QDropEvent *event )
                         CatalogTemplate *tmpl = static_cast<CatalogTemplate*>(itemData(movedItem));
                         if( tmpl && tmpl->chapterId() != newParentId ) {
                             tmpl->setChapterId( newParentId, true );
+                            if( catalog() ) {
+                                catalog()->invalidateChapterIndex();
+                            }
                         }
                     }
                 }
@@ -543,11 +587,82 @@ void KatalogListView::dropEvent( QDropEvent *event )
     QTreeView::dropEvent(event);
 }
 
-void KatalogListView::endUpdateItemSequence()
+bool KatalogListView::endUpdateItemSequence()
 {
-    _query->finish();
+    bool ok = true;
+    if (_query && !_seqIds.isEmpty()) {
+        _query->addBindValue(_seqKeys);
+        _query->addBindValue(_seqIds);
+        if (!_query->execBatch()) {
+            qDebug() << "Failed to update the sort keys:" << _query->lastError().text();
+            ok = false;
+        }
+    }
+    _seqKeys.clear();
+    _seqIds.clear();
+
+    if (_query) {
+        _query->finish();
+    }
     delete _query;
     _query = nullptr;
+    return ok;
+}
+
+QVector<int> KatalogListView::gapSortKeys(const QVector<int>& current)
+{
+    const int n = current.size();
+
+    // the longest strictly increasing subsequence of the current keys
+    QVector<int> tails;
+    QVector<int> prev(n, -1);
+    for (int i = 0; i < n; i++) {
+        auto pos = std::lower_bound(tails.begin(), tails.end(), current.at(i),
+                                    [&current](int idx, int key) { return current.at(idx) < key; });
+        if (pos != tails.begin()) {
+            prev[i] = *(pos - 1);
+        }
+        if (pos == tails.end()) {
+            tails.append(i);
+        } else {
+            *pos = i;
+        }
+    }
+    QVector<bool> kept(n, false);
+    for (int i = tails.isEmpty() ? -1 : tails.last(); i >= 0; i = prev.at(i)) {
+        kept[i] = true;
+    }
+
+    QVector<int> re(current);
+    // the keys start at zero
+    qint64 lo = -1;
+    int i = 0;
+    while (i < n) {
+        if (kept.at(i)) {
+            lo = current.at(i);
+            i++;
+            continue;
+        }
+        int j = i;
+        while (j < n && !kept.at(j)) {
+            j++;
+        }
+        const int k = j - i;
+        const qint64 hi = j < n ? current.at(j) : lo + qint64(k + 1) * SortKeyGap;
+
+        if (hi - lo - 1 < k || hi > std::numeric_limits<int>::max()) {
+            for (int x = 0; x < n; x++) {
+                re[x] = (x + 1) * SortKeyGap;
+            }
+            return re;
+        }
+        for (int m = 0; m < k; m++) {
+            re[i + m] = int(lo + (hi - lo) * (m + 1) / (k + 1));
+        }
+        lo = re.at(j - 1);
+        i = j;
+    }
+    return re;
 }
 
 void KatalogListView::updateChapterSort(int catChapterId)
@@ -561,37 +676,89 @@ void KatalogListView::updateChapterSort(int catChapterId)
 
 void KatalogListView::updateSort(QTreeWidgetItem *chapter)
 {
-    int chapCnt{0};
-    int itemCnt{0};
-
     if (chapter == nullptr) chapter = m_root;
+    populateChapter(chapter);
 
     int childrenCnt = chapter->childCount();
 
     emit sequenceUpdateMaximum(childrenCnt);
 
-    QSqlQuery chapQuery;
-    chapQuery.prepare("UPDATE CatalogChapters SET sortKey = :sk WHERE chapterID = :id");
-
-    startUpdateItemSequence();
-
+    // chapters and items are sorted separately
+    QList<CatalogChapter*> chapters;
+    QVector<int> chapterKeys;
+    QList<QTreeWidgetItem*> items;
+    QVector<int> itemKeys;
     for (int indx = 0; indx < childrenCnt; indx++) {
         QTreeWidgetItem *item = chapter->child(indx);
-
-        emit sequenceUpdateProgress(indx);
-
         if (isChapter(item)) {
-            CatalogChapter *chapter = static_cast<CatalogChapter*>(itemData(item));
-            if (chapter) {
-                chapQuery.bindValue(":id", chapter->id().toInt());
-                chapQuery.bindValue(":sk", chapCnt++);
-                chapQuery.exec();
+            CatalogChapter *chap = static_cast<CatalogChapter*>(itemData(item));
+            if (chap) {
+                chapters.append(chap);
+                chapterKeys.append(chap->sortKey());
             }
         } else {
-            updateItemSequence(item, itemCnt++);
+            items.append(item);
+            itemKeys.append(itemSortKey(item));
+        }
+    }
+
+    // usually only the moved entry gets a new key
+    const QVector<int> newChapterKeys = gapSortKeys(chapterKeys);
+    const QVector<int> newItemKeys = gapSortKeys(itemKeys);
+
+    QSqlDatabase db = QSqlDatabase::database();
+    bool ok = db.transaction();
+
+    QVariantList keys;
+    QVariantList ids;
+    for (int indx = 0; indx < chapters.size(); indx++) {
+        if (newChapterKeys.at(indx) != chapterKeys.at(indx)) {
+            keys.append(newChapterKeys.at(indx));
+            ids.append(chapters.at(indx)->id().toInt());
         }
     }
-    endUpdateItemSequence();
+    if (ok && !ids.isEmpty()) {
+        QSqlQuery chapQuery;
+        chapQuery.prepare("UPDATE CatalogChapters SET sortKey = ? WHERE chapterID = ?");
+        chapQuery.addBindValue(keys);
+        chapQuery.addBindValue(ids);
+        if (!chapQuery.execBatch()) {
+            qDebug() << "Failed to update the chapter sort keys:" << chapQuery.lastError().text();
+            ok = false;
+        }
+    }
+
+    if (ok) {
+        startUpdateItemSequence();
+        for (int indx = 0; indx < items.size(); indx++) {
+            emit sequenceUpdateProgress(chapters.size() + indx);
+            if (newItemKeys.at(indx) != itemKeys.at(indx)) {
+                updateItemSequence(items.at(indx), newItemKeys.at(indx));
+            }
+        }
+        ok = endUpdateItemSequence();
+    }
+
+    if (ok) {
+        ok = db.commit();
+    } else {
+        db.rollback();
+    }
+
+    // the keys in memory must match the database, otherwise a later
+    // move would not write them
+    if (ok) {
+        for (int indx = 0; indx < chapters.size(); indx++) {
+            chapters.at(indx)->setSortKey(newChapterKeys.at(indx));
+        }
+        for (int indx = 0; indx < items.size(); indx++) {
+            if (newItemKeys.at(indx) != itemKeys.at(indx)) {
+                setItemSortKey(items.at(indx), newItemKeys.at(indx));
+            }
+        }
+    } else {
+        qDebug() << "The sort keys were not changed:" << db.lastError().text();
+    }
     emit sequenceUpdateProgress(childrenCnt);
 }
 
@@ -627,6 +794,7 @@ void KatalogListView::slotRedraw()
     m_root = 0;
     m_dataDict.clear();
     mChapterDict.clear();
+    mLazyChapters.clear();
     addCatalogDisplay( m_catalogName );
     mOpenChapters.clear();
 }
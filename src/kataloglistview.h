@@ -22,7 +22,9 @@
 #include <QTreeWidgetItem>
 #include <QTreeWidget>
 #include <QMenu>
+#include <QSet>
 #include <QSqlQuery>
+#include <QVector>
 
 #include "kraftcat_export.h"
 #include "catalogtemplate.h"
@@ -63,6 +65,10 @@ public:
   virtual void saveState() = 0;
   void updateChapterSort(int catChapterId);
 
+  // add the items of chapters that were not expanded yet
+  void populateChapter( QTreeWidgetItem* );
+  void populateAllChapters();
+
 signals:
   void templateHoovered( CatalogTemplate* );
   void sequenceUpdateProgress( int );
@@ -86,28 +92,58 @@ public slots:
 
 protected slots:
   virtual void slotItemEntered( QTreeWidgetItem*, int);
+  void slotItemExpanded( QTreeWidgetItem* );
   // run an update of the sort key in a chapter.
   void updateSort(QTreeWidgetItem *chapter);
 
+public:
+  // the distance of the sort keys if a chapter is renumbered
+  static const int SortKeyGap = CatalogTemplate::SortKeyGap;
+
+  /*
+   * Returns strictly increasing sort keys for items shown in the order
+   * of the given current keys. The longest run of keys that is already
+   * in order is kept, the other items get keys from the gaps in between.
+   * Only if a gap is too small, all keys are renumbered with SortKeyGap.
+   */
+  static QVector<int> gapSortKeys( const QVector<int>& current );
+
 protected:
+  // updateItemSequence is only called for items with a changed sort key.
+  // The keys are collected and written in one batch by endUpdateItemSequence,
+  // which returns false if the batch failed. The keys of the items are set
+  // with setItemSortKey only after the transaction is committed.
   virtual void startUpdateItemSequence() = 0;
   virtual void updateItemSequence(QTreeWidgetItem *item, int seqNo) = 0;
-  virtual void endUpdateItemSequence();
+  virtual bool endUpdateItemSequence();
+  virtual int itemSortKey(QTreeWidgetItem *item) = 0;
+  virtual void setItemSortKey(QTreeWidgetItem *item, int seqNo) = 0;
 
   virtual Katalog* catalog();
   void dropEvent( QDropEvent* );
 
+  /*
+   * The items of a chapter can be added when the chapter is expanded
+   * the first time. Such chapters are marked lazy, the derived view
+   * adds the items in addChapterItems.
+   */
+  void setChapterLazy( QTreeWidgetItem* );
+  virtual void addChapterItems( QTreeWidgetItem*, int /* chapterId */ ) {}
+
   bool             mCheckboxes;
   QTreeWidgetItem* tryAddingCatalogChapter( const CatalogChapter& );
 
   QTreeWidgetItem *m_root;
   QHash<QTreeWidgetItem*, void*> m_dataDict;
   QHash<int, QTreeWidgetItem*> mChapterDict;
+  QSet<QTreeWidgetItem*> mLazyChapters;
   QString m_catalogName;
   QStringList mOpenChapters;
   QMenu *mMenu;
   QFont mChapterFont;
   QSqlQuery *_query;
+  QVariantList _seqKeys;
+  QVariantList _seqIds;
 };
 
 #endif
@@ -19,6 +19,8 @@
 #include <QtCore>
 #include <QSqlQuery>
 #include <QGlobalStatic>
+#include <QCryptographicHash>
+#include <QStandardPaths>
 
 #include "kraftdb.h"
 #include "katalogman.h"
@@ -35,7 +37,9 @@ KatalogMan *KatalogMan::self()
 
 KatalogMan::KatalogMan( )
 {
-
+  mUsageFlushTimer.setSingleShot( true );
+  mUsageFlushTimer.setInterval( 30000 );
+  connect( &mUsageFlushTimer, &QTimer::timeout, this, &KatalogMan::flushUsage );
 }
 
 KatalogMan::~KatalogMan( )
@@ -82,10 +86,41 @@ void KatalogMan::registerKatalog( Katalog *k )
         // not found, try to open it
         // qDebug () << "Katalog " << k->getName() << " registered and loading..." << endl;
         m_katalogDict.insert( k->getName(), k );
-        k->load ();
+        loadKatalog( k );
     }
 }
 
+/*
+ * Template catalogs are read from their snapshot if the catalog has not
+ * changed since it was written. Otherwise they are loaded from the
+ * database and the snapshot is written again.
+ */
+void KatalogMan::loadKatalog( Katalog *k )
+{
+    if( k->type() != TemplateCatalog ) {
+        k->load();
+        return;
+    }
+
+    TemplKatalog *tk = static_cast<TemplKatalog*>( k );
+    const QString file = snapshotFile( k->getName() );
+    if( tk->loadSnapshot( file ) ) {
+        return;
+    }
+    tk->load();
+    tk->writeSnapshot( file );
+}
+
+QString KatalogMan::snapshotFile( const QString& name ) const
+{
+    // the database is part of the name, the catalogs of two databases
+    // have the same name
+    const QByteArray id = QCryptographicHash::hash( ( KraftDB::self()->databaseName() + QLatin1Char('/') + name ).toUtf8(),
+                                                    QCryptographicHash::Sha1 ).toHex();
+    return QStandardPaths::writableLocation( QStandardPaths::CacheLocation )
+            + QStringLiteral( "/catalogs/" ) + QString::fromLatin1( id ) + QStringLiteral( ".snapshot" );
+}
+
 Katalog *KatalogMan::getKatalog(const QString& name)
 {
     Katalog* kat = m_katalogDict[name];
@@ -134,6 +169,23 @@ void KatalogMan::registerKatalogListView( const QString& name, KatalogListView *
  * one template catalog is in use.
  */
 
+void KatalogMan::scheduleUsageFlush()
+{
+  if( !mUsageFlushTimer.isActive() ) {
+    mUsageFlushTimer.start();
+  }
+}
+
+void KatalogMan::flushUsage()
+{
+  mUsageFlushTimer.stop();
+  for( Katalog *k : m_katalogDict ) {
+    if( k && k->hasPendingUsage() ) {
+      k->flushUsage();
+    }
+  }
+}
+
 Katalog* KatalogMan::defaultTemplateCatalog()
 {
   QHashIterator<QString, Katalog*> it( m_katalogDict ); // See QDictIterator
@@ -148,6 +200,17 @@ Katalog* KatalogMan::defaultTemplateCatalog()
   return 0;
 }
 
+QList<Katalog*> KatalogMan::templateCatalogs()
+{
+  QList<Katalog*> re;
+  for( Katalog *k : m_katalogDict ) {
+    if( k && k->type() == TemplateCatalog ) {
+      re.append( k );
+    }
+  }
+  return re;
+}
+
 KatalogMan::CatalogDetails KatalogMan::catalogDetails( const QString& catName )
 {
     KatalogMan::CatalogDetails details;
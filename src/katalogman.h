@@ -19,6 +19,7 @@
 #define _KATALOGMAN_H
 
 #include <qmap.h>
+#include <QTimer>
 
 #include "katalog.h"
 #include "kataloglistview.h"
@@ -47,20 +48,31 @@ public:
     QStringList allKatalogNames();
     Katalog* getKatalog(const QString&);
     Katalog* defaultTemplateCatalog();
+    QList<Katalog*> templateCatalogs();
     void     registerKatalog( Katalog* );
     QString  catalogTypeString( const QString& catName );
     void     notifyKatalogChange( Katalog*, dbID );
     CatalogDetails catalogDetails( const QString& catName );
 
+    // the file of the binary snapshot of a template catalog
+    QString  snapshotFile( const QString& name ) const;
+
     // register a view for a catalog identified by its name.
     void     registerKatalogListView( const QString&, KatalogListView* );
 
+    // the recorded usages of the catalog items are written after a while,
+    // or when flushUsage is called, e.g. when a document is saved.
+    void     scheduleUsageFlush();
+    void     flushUsage();
+
     // static KatalogMan *mSelf;
     KatalogMan();
 
 private:
+    void loadKatalog( Katalog* );
 
     QHash<QString, Katalog*> m_katalogDict;
+    QTimer mUsageFlushTimer;
 
     QMultiMap< QString, QPointer<KatalogListView> > mKatalogListViews;
 };
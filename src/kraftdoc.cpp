@@ -261,30 +261,30 @@ int KraftDoc::slotAppendPosition( const DocPosition& pos )
 
 Geld KraftDoc::nettoSum() const
 {
-  return positions().nettoPrice();
+  // the member caches the totals, not a copy of it
+  return mPositions.totals().netto();
 }
 
 Geld KraftDoc::bruttoSum() const
 {
-  Geld g = nettoSum();
-  g += vatSum();
-  return g;
+  return mPositions.totals().brutto( DocumentMan::self()->tax( date() ),
+                                     DocumentMan::self()->reducedTax( date() ) );
 }
 
 Geld KraftDoc::fullTaxSum() const
 {
-    return positions().fullTaxSum(DocumentMan::self()->tax(date()));
+    return mPositions.totals().fullTax(DocumentMan::self()->tax(date()));
 }
 
 Geld KraftDoc::reducedTaxSum() const
 {
-    return positions().reducedTaxSum(DocumentMan::self()->reducedTax(date()));
+    return mPositions.totals().reducedTax(DocumentMan::self()->reducedTax(date()));
 }
 
 Geld KraftDoc::vatSum() const
 {
-  return positions().taxSum( DocumentMan::self()->tax( date() ),
-                             DocumentMan::self()->reducedTax( date() ) );
+  return mPositions.totals().taxSum( DocumentMan::self()->tax( date() ),
+                                     DocumentMan::self()->reducedTax( date() ) );
 
   // return Geld( nettoSum() * DocumentMan::self()->vat()/100.0 );
 }
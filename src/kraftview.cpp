@@ -79,6 +79,9 @@
 #define FULL_TAX 2
 #define INDI_TAX 3
 
+// milliseconds, about one frame
+static const int PostCardRefreshDelay = 16;
+
 KraftView::KraftView(QWidget *parent) :
   KraftViewBase( parent ),
   mHelpLabel(nullptr), mRememberAmount( -1 ), mModified( false ),
@@ -143,6 +146,12 @@ KraftView::KraftView(QWidget *parent) :
 
   mAssistant->slotSelectDocPart( KraftDoc::Header );
 
+  // see schedulePostCardRefresh()
+  mPostCardTimer = new QTimer( this );
+  mPostCardTimer->setSingleShot( true );
+  mPostCardTimer->setInterval( PostCardRefreshDelay );
+  connect( mPostCardTimer, SIGNAL( timeout() ), this, SLOT( refreshPostCard() ) );
+
   setupMappers();
 
   QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok|QDialogButtonBox::Cancel);
@@ -159,6 +168,7 @@ KraftView::KraftView(QWidget *parent) :
 KraftView::~KraftView()
 {
     // qDebug () << "KRAFTVIEW going away." << endl;
+    KatalogMan::self()->flushUsage();
 }
 
 void KraftView::setupMappers()
@@ -577,8 +587,23 @@ DocPositionBase::TaxType KraftView::currentTaxSetting()
   return tt;
 }
 
+/*
+ * Edits do not refresh the postcard right away but start a short timer
+ * that is not restarted while it runs. That way a burst of keystrokes
+ * refreshes the postcard at most once per frame.
+ */
+void KraftView::schedulePostCardRefresh()
+{
+  if ( !mPostCardTimer->isActive() ) {
+    mPostCardTimer->start();
+  }
+}
+
 void KraftView::refreshPostCard()
 {
+  // a direct call makes a pending refresh obsolete
+  mPostCardTimer->stop();
+
   DocPositionList positions = currentPositionList();
 
   if( !getDocument() ) return;
@@ -748,7 +773,7 @@ void KraftView::slotMovePositionUp( int pos )
 
     m_positionScroll->moveChild( w2, m_positionScroll->indexOf(w1) );
     mModified = true;
-    QTimer::singleShot( 0, this, SLOT(refreshPostCard()  ) );
+    schedulePostCardRefresh();
   } else {
     // qDebug () << "ERR: Did not find the two corresponding widgets!" << endl;
   }
@@ -784,7 +809,7 @@ void KraftView::slotMovePositionDown( int pos )
     m_positionScroll->moveChild( w1, m_positionScroll->indexOf( w2 ) );
 
     mModified = true;
-    QTimer::singleShot( 0, this, SLOT( refreshPostCard() ) );
+    schedulePostCardRefresh();
   } else {
     // qDebug () << "ERR: Did not find the two corresponding widgets!" << endl;
   }
@@ -826,7 +851,7 @@ void KraftView::slotPositionModified( int )
     // qDebug () << "Modified Position " << pos << endl;
     mModified = true;
 
-    QTimer::singleShot( 0, this, SLOT( refreshPostCard() ) );
+    schedulePostCardRefresh();
 }
 
 void KraftView::slotAddressFound(const QString& uid, const KContacts::Addressee& contact)
@@ -1307,7 +1332,7 @@ void KraftView::slotModifiedHeader()
 
     mModified = true;
 
-    QTimer::singleShot( 0, this, SLOT( refreshPostCard() ) );
+    schedulePostCardRefresh();
 }
 
 void KraftView::slotModifiedFooter()
@@ -1320,7 +1345,7 @@ void KraftView::slotModifiedFooter()
 
     mModified = true;
 
-    QTimer::singleShot( 0, this, SLOT( refreshPostCard() ) );
+    schedulePostCardRefresh();
 }
 
 QStringList KraftView::generateLetterHead( const QString& familyName, const QString& givenName )
@@ -1364,6 +1389,7 @@ void KraftView::done( int r )
 void KraftView::saveChanges()
 {
     // qDebug () << "Saving changes!" << endl;
+    KatalogMan::self()->flushUsage();
 
     KraftDoc *doc = getDocument();
 
@@ -168,6 +168,7 @@ private:
   void setupFooter();
   void setupTextsView();
   void setMappingId( QWidget *, int );
+  void schedulePostCardRefresh();
   void setupMappers();
   void saveChanges();
   void discardChanges();
@@ -203,6 +204,7 @@ private:
   QStackedWidget *mViewStack;
   int             mHeaderId;
   DocAssistant   *mAssistant;
+  QTimer         *mPostCardTimer;
   double         mRememberAmount;
   QMap<dbID, CalcPartList> mCalculationsMap;
 
@@ -26,6 +26,9 @@
 #include <QStandardPaths>
 #include <QSplashScreen>
 #include <QScopedPointer>
+#include <QTextStream>
+#include <QTimer>
+#include <QDate>
 
 #include <KLocalizedString>
 
@@ -33,6 +36,77 @@
 #include "portal.h"
 #include "defaultprovider.h"
 #include "archdocposition.h"
+#include "batchrenderer.h"
+#include "xrechnungbatchexporter.h"
+#include "rendertrace.h"
+#include "kraftsettings.h"
+
+namespace {
+
+int renderHeadless(QApplication& app, const QCommandLineParser& parser)
+{
+    const QDate from = QDate::fromString(parser.value(QStringLiteral("from")), Qt::ISODate);
+    const QDate to = QDate::fromString(parser.value(QStringLiteral("to")), Qt::ISODate);
+
+    BatchRenderer renderer;
+    renderer.setDateRange(from, to);
+    renderer.setOutputDir(parser.value(QStringLiteral("outdir")));
+    if (parser.isSet(QStringLiteral("jobs"))) {
+        renderer.setMaxJobs(parser.value(QStringLiteral("jobs")).toInt());
+    }
+    if (parser.isSet(QStringLiteral("trace"))) {
+        renderer.setTraceFile(parser.value(QStringLiteral("trace")));
+    }
+    if (parser.isSet(QStringLiteral("job-timeout"))) {
+        renderer.setJobTimeout(parser.value(QStringLiteral("job-timeout")).toInt());
+    }
+
+    QObject::connect(&renderer, &BatchRenderer::finished, &app, &QApplication::exit);
+    QTimer::singleShot(0, &renderer, &BatchRenderer::start);
+
+    const int re = app.exec();
+
+    QTextStream out(re == BatchRenderer::Success ? stdout : stderr);
+    out << renderer.summary() << endl;
+    return re;
+}
+
+
+int exportXRechnungHeadless(QApplication& app, const QCommandLineParser& parser)
+{
+    const QDate from = QDate::fromString(parser.value(QStringLiteral("from")), Qt::ISODate);
+    const QDate to = QDate::fromString(parser.value(QStringLiteral("to")), Qt::ISODate);
+
+    XRechnungBatchExporter exporter;
+    exporter.setDateRange(from, to);
+    exporter.setIdents(parser.values(QStringLiteral("ident")));
+    exporter.setOutputDir(parser.value(QStringLiteral("outdir")));
+    exporter.setSchemaFile(parser.value(QStringLiteral("xsd")));
+    exporter.setSchematronFile(parser.value(QStringLiteral("schematron")));
+    if (parser.isSet(QStringLiteral("jobs"))) {
+        exporter.setMaxJobs(parser.value(QStringLiteral("jobs")).toInt());
+    }
+    if (parser.isSet(QStringLiteral("due-days"))) {
+        exporter.setDueDays(parser.value(QStringLiteral("due-days")).toInt());
+    }
+    if (parser.isSet(QStringLiteral("buyer-ref"))) {
+        exporter.setBuyerRef(parser.value(QStringLiteral("buyer-ref")));
+    }
+    if (parser.isSet(QStringLiteral("lookup-timeout"))) {
+        exporter.setLookupTimeout(parser.value(QStringLiteral("lookup-timeout")).toInt());
+    }
+
+    QObject::connect(&exporter, &XRechnungBatchExporter::finished, &app, &QApplication::exit);
+    QTimer::singleShot(0, &exporter, &XRechnungBatchExporter::start);
+
+    const int re = app.exec();
+
+    QTextStream out(re == XRechnungBatchExporter::Success ? stdout : stderr);
+    out << exporter.summary() << endl;
+    return re;
+}
+
+}
 
 int main(int argc, char *argv[])
 {
@@ -41,6 +115,15 @@ int main(int argc, char *argv[])
 
     qRegisterMetaType<ArchDocPositionList>("ArchDocPositionList");
 
+    // The headless render mode must not require a display, so it is
+    // detected before the application object is created.
+    for (int i = 1; i < argc; i++) {
+        if ((qstrcmp(argv[i], "--render") == 0 || qstrcmp(argv[i], "--xrechnung") == 0)
+                && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        }
+    }
+
     QApplication app(argc, argv);
     app.setWindowIcon(QIcon(":/kraft/global/32-apps-kraft.png"));
     app.setApplicationName("kraft");
@@ -53,12 +136,41 @@ int main(int argc, char *argv[])
     parser.addOption(QCommandLineOption(QStringList() << QLatin1String("d"), i18n("Open document with arch doc number <number>"), QLatin1String("number")));
     parser.addOption(QCommandLineOption(QStringList() << QLatin1String("r"), i18n("Open Kraft in read only mode - document changes prohibited") ));
 
+    parser.addOption(QCommandLineOption(QStringList() << QLatin1String("render"), i18n("Render all archived documents in a date range to PDF without a window")));
+    parser.addOption(QCommandLineOption(QStringList() << QLatin1String("from"), i18n("First document date to render, as yyyy-MM-dd"), QLatin1String("date")));
+    parser.addOption(QCommandLineOption(QStringList() << QLatin1String("to"), i18n("Last document date to render, as yyyy-MM-dd"), QLatin1String("date")));
+    parser.addOption(QCommandLineOption(QStringList() << QLatin1String("outdir"), i18n("Directory to write the rendered PDF files to, default is the PDF archive"), QLatin1String("dir")));
+    parser.addOption(QCommandLineOption(QStringList() << QLatin1String("jobs"), i18n("Amount of documents rendered in parallel, default is the amount of cores"), QLatin1String("number")));
+    parser.addOption(QCommandLineOption(QStringList() << QLatin1String("job-timeout"), i18n("Seconds after which a document that is not rendered counts as failed, 0 waits forever, default is 300"), QLatin1String("seconds")));
+    parser.addOption(QCommandLineOption(QStringList() << QLatin1String("trace"), i18n("Record the time of the render phases and write them as Chrome trace to <file>"), QLatin1String("file")));
+
+    parser.addOption(QCommandLineOption(QStringList() << QLatin1String("xrechnung"), i18n("Export the archived invoices in a date range or with the given idents as XRechnung without a window")));
+    parser.addOption(QCommandLineOption(QStringList() << QLatin1String("ident"), i18n("Ident of an invoice to export, can be given more than once"), QLatin1String("ident")));
+    parser.addOption(QCommandLineOption(QStringList() << QLatin1String("due-days"), i18n("Days from the invoice date to the due date, default is 21"), QLatin1String("days")));
+    parser.addOption(QCommandLineOption(QStringList() << QLatin1String("buyer-ref"), i18n("Buyer reference for all exported invoices"), QLatin1String("reference")));
+    parser.addOption(QCommandLineOption(QStringList() << QLatin1String("lookup-timeout"), i18n("Seconds to wait for the address of a customer, 0 skips the lookup, default is 30"), QLatin1String("seconds")));
+    parser.addOption(QCommandLineOption(QStringList() << QLatin1String("xsd"), i18n("Validate the exported files against this local XML schema file"), QLatin1String("file")));
+    parser.addOption(QCommandLineOption(QStringList() << QLatin1String("schematron"), i18n("Validate the exported files against this local Schematron file"), QLatin1String("file")));
+
     parser.process(app);
 
+    RenderTrace::self()->setEnabled(KraftSettings::self()->renderTracing() || parser.isSet(QStringLiteral("trace")));
+
+    if (parser.isSet(QStringLiteral("render"))) {
+        return renderHeadless(app, parser);
+    }
+    if (parser.isSet(QStringLiteral("xrechnung"))) {
+        return exportXRechnungHeadless(app, parser);
+    }
+
     // Register the supported options
     QScopedPointer<Portal> kraftPortal;
     kraftPortal.reset( new Portal( nullptr, &parser, "kraft main window" ));
     kraftPortal->show();
 
-    return app.exec();
+    const int re = app.exec();
+    if (RenderTrace::self()->isEnabled()) {
+        qDebug().noquote() << RenderTrace::self()->summary();
+    }
+    return re;
 }
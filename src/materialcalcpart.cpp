@@ -30,7 +30,9 @@
 
 MaterialCalcPart::MaterialCalcPart()
   : CalcPart(),
-    m_calcID( 0 )
+    m_calcID( 0 ),
+    m_calcAmount( 0 ),
+    m_mat( nullptr )
 {
 }
 
@@ -46,7 +48,7 @@ MaterialCalcPart::MaterialCalcPart( long mCalcID, long matID, int percent, doubl
 }
 
 MaterialCalcPart::MaterialCalcPart(long matID, int percent, double amount)
-    : CalcPart( percent), m_calcID(0), m_calcAmount(amount)
+    : CalcPart( percent), m_calcID(0), m_calcAmount(amount), m_mat(nullptr)
 {
     getMatFromID(matID);
     if( m_mat ) {
@@ -54,12 +56,22 @@ MaterialCalcPart::MaterialCalcPart(long matID, int percent, double amount)
     }
 }
 
+MaterialCalcPart::MaterialCalcPart( long mCalcID, StockMaterial *mat, int percent, double amount )
+    : CalcPart( percent), m_calcID( mCalcID ),
+      m_calcAmount(amount),
+      m_mat(mat)
+{
+    if( m_mat ) {
+        setName(m_mat->getText());
+    }
+}
+
 MaterialCalcPart::~MaterialCalcPart( )
 {
   // do not delete m_mat because it comes straight from stockmaterialman
 }
 
-void MaterialCalcPart::getMatFromID(long matID)
+MatKatalog* MaterialCalcPart::materialCatalog()
 {
     MatKatalog *k = static_cast<MatKatalog*>(KatalogMan::self()->getKatalog( MaterialKatalogView::MaterialCatalogName ));
     if( !k ) {
@@ -68,6 +80,12 @@ void MaterialCalcPart::getMatFromID(long matID)
             KatalogMan::self()->registerKatalog(k);
         }
     }
+    return k;
+}
+
+void MaterialCalcPart::getMatFromID(long matID)
+{
+    MatKatalog *k = materialCatalog();
     if( k ) {
         m_mat = k->materialFromId(matID);
     }
@@ -27,6 +27,7 @@
  */
 class StockMaterial;
 class StockMaterialList;
+class MatKatalog;
 class QString;
 class QVariant;
 
@@ -37,6 +38,8 @@ public:
     MaterialCalcPart();
     MaterialCalcPart( long mCalcID, long matID, int procent, double amount );
     MaterialCalcPart( long matID, int procent, double amount );
+    /** with the material already looked up, used to load many parts */
+    MaterialCalcPart( long mCalcID, StockMaterial *mat, int procent, double amount );
     ~MaterialCalcPart();
 
     virtual Geld basisKosten();
@@ -47,6 +50,9 @@ public:
     bool setCalcAmount( double newAmount );
     double getCalcAmount(){return m_calcAmount;};
 
+    /** the material catalog, which is loaded on first use */
+    static MatKatalog* materialCatalog();
+
 protected:
     void getMatFromID(long matID);
 
@@ -155,17 +155,29 @@ void MaterialKatalogListView::saveState()
 void MaterialKatalogListView::startUpdateItemSequence()
 {
     _query = new QSqlQuery;
-    _query->prepare("UPDATE stockMaterial SET sortKey = :sk WHERE matID=:id");
+    _query->prepare("UPDATE stockMaterial SET sortKey = ? WHERE matID = ?");
 }
 
 void MaterialKatalogListView::updateItemSequence(QTreeWidgetItem *item, int seqNo)
 {
     StockMaterial *mat = static_cast<StockMaterial*>( m_dataDict[item] );
     if ( mat ) {
-        int id = mat->getID();
-        _query->bindValue(":id", id);
-        _query->bindValue(":sk", seqNo);
-        _query->exec();
+        _seqKeys.append(seqNo);
+        _seqIds.append(mat->getID());
+    }
+}
+
+int MaterialKatalogListView::itemSortKey(QTreeWidgetItem *item)
+{
+    StockMaterial *mat = static_cast<StockMaterial*>( m_dataDict.value(item) );
+    return mat ? mat->sortKey() : 0;
+}
+
+void MaterialKatalogListView::setItemSortKey(QTreeWidgetItem *item, int seqNo)
+{
+    StockMaterial *mat = static_cast<StockMaterial*>( m_dataDict.value(item) );
+    if ( mat ) {
+        mat->setSortKey(seqNo);
     }
 }
 
@@ -49,6 +49,8 @@ protected:
   void startUpdateItemSequence();
 
   void updateItemSequence(QTreeWidgetItem *item, int seqNo);
+  int itemSortKey(QTreeWidgetItem *item);
+  void setItemSortKey(QTreeWidgetItem *item, int seqNo);
 
 };
 
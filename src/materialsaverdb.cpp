@@ -20,6 +20,7 @@
 #include <QDateTime>
 #include <QSqlTableModel>
 #include <QSqlRecord>
+#include <QSqlQuery>
 #include <QDebug>
 #include <QGlobalStatic>
 
@@ -28,6 +29,7 @@
 #include "dbids.h"
 #include "materialsaverdb.h"
 #include "stockmaterial.h"
+#include "templkatalog.h"
 
 MaterialSaverDB::MaterialSaverDB( )
     : MaterialSaverBase()
@@ -62,9 +64,16 @@ bool MaterialSaverDB::saveTemplate( StockMaterial *mat )
 
         // mach update
         buffer = model.record(0);
+        const bool priceChanged = qAbs(buffer.value("priceOut").toDouble() - mat->salesPrice().toDouble()) > 0.001
+                || qAbs(buffer.value("perPack").toDouble() - mat->getAmountPerPack()) > 0.00001;
         fillMaterialBuffer( buffer, mat, false );
         model.setRecord(0, buffer);
         model.submitAll();
+
+        // the stored prices of the templates using the material are outdated
+        if( priceChanged ) {
+            TemplKatalog::materialChanged( mat->getID() );
+        }
     }
     else
     {
@@ -105,6 +114,17 @@ void MaterialSaverDB::fillMaterialBuffer( QSqlRecord &rec, StockMaterial *mat, b
 
   if( isNew ) {
     rec.setValue( "enterDate", dtString);
+
+    // behind the last material of the chapter
+    QSqlQuery q;
+    q.prepare( "SELECT MAX(sortKey) FROM stockMaterial WHERE chapterID=:chap" );
+    q.bindValue( ":chap", mat->chapter() );
+    int key = 0;
+    if( q.exec() && q.next() ) {
+      key = q.value(0).toInt();
+    }
+    mat->setSortKey( key + CatalogTemplate::SortKeyGap );
+    rec.setValue( "sortKey", mat->sortKey() );
   }
   rec.setValue("modifyDate", dtString );
 }
@@ -23,15 +23,19 @@
 #include <QDebug>
 #include <QDialog>
 #include <QDialogButtonBox>
+#include <QMessageBox>
 #include <QPushButton>
 #include <QVBoxLayout>
 
+#include <KLocalizedString>
+
 #include "materialtempldialog.h"
 #include "katalogman.h"
 #include "unitmanager.h"
 #include "geld.h"
 #include "kraftsettings.h"
 #include "defaultprovider.h"
+#include "templkatalog.h"
 
 MaterialTemplDialog::MaterialTemplDialog( QWidget *parent, bool modal )
     : QDialog( parent ),
@@ -205,6 +209,20 @@ void MaterialTemplDialog::accept()
   if ( newMat.isEmpty() ) {
     // qDebug () << "We do not want to store empty materials" << endl;
   } else {
+    if ( !m_templateIsNew
+         && ( qAbs( mInSalePrice->value() - mSaveMaterial->salesPrice().toDouble() ) > Eta
+              || qAbs( mDiPerPack->value() - mSaveMaterial->getAmountPerPack() ) > Eta ) ) {
+      const int cnt = TemplKatalog::materialUsage( mSaveMaterial->getID() );
+      if ( cnt > 0 && QMessageBox::question( this, i18n("Change Material Price"),
+                                             i18np("The price of one catalog template is calculated with this material "
+                                                   "and will be updated. Change the price?",
+                                                   "The prices of %1 catalog templates are calculated with this material "
+                                                   "and will be updated. Change the price?", cnt)
+                                             ) == QMessageBox::No ) {
+        return;
+      }
+    }
+
     mSaveMaterial->setText( mEditMaterial->toPlainText() );
     mSaveMaterial->setAmountPerPack( mDiPerPack->value() );
 
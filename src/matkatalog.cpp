@@ -38,7 +38,6 @@ MatKatalog::MatKatalog()
 
 void MatKatalog::reload( dbID )
 {
-  mAllMaterial.clear();
   load();
 }
 
@@ -47,8 +46,12 @@ int MatKatalog::load()
   Katalog::load();
   int cnt = 0;
 
+  mAllMaterial.clear();
+  mMaterialById.clear();
+  mChapterMaterials.clear();
+
   QSqlQuery q(QLatin1String("SELECT matID, chapterID, material, unitID, perPack, priceIn, "
-              "priceOut, modifyDate, enterDate FROM stockMaterial ORDER BY chapterID, sortKey"));
+              "priceOut, modifyDate, enterDate, sortKey FROM stockMaterial ORDER BY chapterID, sortKey"));
   q.exec();
   while ( q.next() ) {
     cnt++;
@@ -66,13 +69,15 @@ int MatKatalog::load()
                                             pPack, Geld( priceIn ), Geld( priceOut ) );
     mat->setEnterDate(entered);
     mat->setModifyDate(lastMod);
+    mat->setSortKey(q.value(9).toInt());
 
     auto usage = usageCount(id);
     mat->setLastUsedDate(usage.second);
     mat->setUseCounter(usage.first);
+    mUsage.insert(id, usage);
 
     mAllMaterial.append( mat );
-
+    indexMaterial( mat );
   }
 
   return cnt;
@@ -92,7 +97,9 @@ void MatKatalog::deleteMaterial( int id )
     cnt++;
   }
   if( cnt < mAllMaterial.count() ) {
-    mAllMaterial.removeAt( cnt );
+    StockMaterial *mat = mAllMaterial.takeAt( cnt );
+    mMaterialById.remove( id );
+    mChapterMaterials[mat->chapter()].removeOne( mat );
   }
 
   // remove from database.
@@ -106,35 +113,26 @@ void MatKatalog::deleteMaterial( int id )
 
 }
 
-StockMaterialList MatKatalog::getRecordList( int chapterId )
+void MatKatalog::indexMaterial( StockMaterial *mat )
 {
-  StockMaterialList list;
+  mMaterialById.insert( mat->getID(), mat );
+  mChapterMaterials[mat->chapter()].append( mat );
+}
 
-  for (StockMaterial *mat: mAllMaterial) {
-    if ( mat->chapter() == chapterId ) {
-      list.append( mat );
-    }
-  }
-  return list;
+StockMaterialList MatKatalog::getRecordList( int chapterId )
+{
+  return mChapterMaterials.value( chapterId );
 }
 
 StockMaterial* MatKatalog::materialFromId( long id )
 {
-    StockMaterialListIterator it( mAllMaterial );
-
-    while( it.hasNext() ) {
-        StockMaterial *mat = it.next();
-
-        if ( mat->getID() == id ) {
-            return mat;
-        }
-    }
-    return nullptr;
+  return mMaterialById.value( id, nullptr );
 }
 
 void MatKatalog::addNewMaterial( StockMaterial *mat )
 {
   mAllMaterial.append( mat );
+  indexMaterial( mat );
 }
 
 
@@ -20,6 +20,7 @@
 
 // include files
 #include <qstring.h>
+#include <QHash>
 
 #include "stockmaterial.h"
 #include "katalog.h"
@@ -46,7 +47,12 @@ public:
   StockMaterialList getRecordList(int chapterId);
   void addNewMaterial( StockMaterial* );
 private:
+  void indexMaterial( StockMaterial* );
+
   StockMaterialList mAllMaterial;
+  // built while loading, the chapter lists keep the sort order
+  QHash<long, StockMaterial*> mMaterialById;
+  QHash<int, StockMaterialList> mChapterMaterials;
 };
 
 #endif
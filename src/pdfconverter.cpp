@@ -18,6 +18,8 @@
 #include "pdfconverter.h"
 #include "defaultprovider.h"
 #include "archiveman.h"
+#include "kraftsettings.h"
+#include "rendertrace.h"
 
 #include <QObject>
 #include <QTemporaryFile>
@@ -26,22 +28,65 @@
 #include <QDebug>
 #include <QApplication>
 #include <QProcess>
+#include <QPointer>
+#include <QJsonArray>
+#include <QJsonObject>
 
 PDFConverter::PDFConverter()
-    : QObject()
+    : QObject(),
+      _watermarkApplied(false),
+      _traceStart(-1)
 {
 
 }
 
+void PDFConverter::traceSpan(const QString& phase)
+{
+    RenderTrace::self()->addSpan(phase, _traceIdent, _traceTemplate, _traceStart);
+}
+
+void PDFConverter::addSource(QJsonObject& job) const
+{
+    if (_sourceFile.isEmpty()) {
+        job.insert(QStringLiteral("data"), QString::fromUtf8(_sourceData));
+    } else {
+        job.insert(QStringLiteral("source"), _sourceFile);
+    }
+}
+
+void PDFConverter::removeSourceFile()
+{
+    if (!_sourceFile.isEmpty()) {
+        QFile::remove(_sourceFile);
+    }
+}
+
 // ====================================================================
 
 
 ReportLabPDFConverter::ReportLabPDFConverter()
-    :PDFConverter()
+    :PDFConverter(),
+      _workerJobId(-1)
 {
 
 }
 
+ConverterWorkerPool *ReportLabPDFConverter::workerPool()
+{
+    static QPointer<ConverterWorkerPool> pool;
+
+    if (!pool && KraftSettings::self()->useConverterWorker()) {
+        // only the erml2pdf.py script knows the server mode
+        const QStringList rmlbin = DefaultProvider::self()->findTrml2Pdf();
+        if (rmlbin.size() > 1 && rmlbin.at(1).endsWith("erml2pdf.py")) {
+            // the pool lives as long as the application
+            pool = new ConverterWorkerPool(rmlbin.at(0), QStringList() << rmlbin.at(1) << QStringLiteral("--server"),
+                                           KraftSettings::self()->converterWorkers(), qApp);
+        }
+    }
+    return pool;
+}
+
 void ReportLabPDFConverter::convert(const QString& sourceFile, const QString &outputPath)
 {
     // qDebug() << "Report BASE:\n" << templ;
@@ -49,18 +94,97 @@ void ReportLabPDFConverter::convert(const QString& sourceFile, const QString &ou
     if ( sourceFile.isEmpty() ) {
         return;
     }
+    _sourceFile = sourceFile;
+    _sourceData.clear();
+
+    startConversion(outputPath);
+}
+
+void ReportLabPDFConverter::convertData(const QByteArray& source, const QString &outputPath)
+{
+    if ( source.isEmpty() ) {
+        return;
+    }
+    _sourceFile.clear();
+    _sourceData = source;
+
+    startConversion(outputPath);
+}
+
+void ReportLabPDFConverter::startConversion(const QString &outputPath)
+{
+    mErrors.clear();
+
+    QApplication::setOverrideCursor( QCursor( Qt::BusyCursor ) );
+
+    ConverterWorkerPool *pool = workerPool();
+    if (pool && pool->isAvailable()) {
+        mFile.setFileName(outputPath);
+
+        QJsonObject job;
+        addSource(job);
+        job.insert(QStringLiteral("output"), outputPath);
+        if (!_watermarkFile.isEmpty()) {
+            job.insert(QStringLiteral("watermarkMode"), _watermarkMode);
+            job.insert(QStringLiteral("watermarkFile"), _watermarkFile);
+        }
+
+        connect(pool, &ConverterWorkerPool::jobFinished, this, &ReportLabPDFConverter::slotWorkerJobFinished);
+        _traceStart = RenderTrace::self()->now();
+        _workerJobId = pool->submit(job);
+        qDebug() << "Submitted job" << _workerJobId << "to the erml2pdf worker";
+    } else {
+        convertWithProcess(outputPath);
+    }
+}
+
+void ReportLabPDFConverter::slotWorkerJobFinished(int jobId, ConverterWorkerPool::Result result, const QString& error)
+{
+    if (jobId != _workerJobId) {
+        return;
+    }
+    disconnect(qobject_cast<ConverterWorkerPool*>(sender()), nullptr, this, nullptr);
+    _workerJobId = -1;
+
+    if (result == ConverterWorkerPool::Result::WorkerUnavailable) {
+        // fall back to one erml2pdf process for this document
+        convertWithProcess(mFile.fileName());
+        return;
+    }
+
+    traceSpan(QStringLiteral("Worker conversion"));
+    QApplication::restoreOverrideCursor();
+
+    if (result == ConverterWorkerPool::Result::Success && QFileInfo::exists(mFile.fileName())) {
+        removeSourceFile();
+        _watermarkApplied = !_watermarkFile.isEmpty();
+        emit docAvailable(mFile.fileName());
+    } else if (result == ConverterWorkerPool::Result::Success) {
+        emit converterError(ConvError::TargetFileMissing);
+    } else {
+        mErrors = error;
+        if (mErrors.contains(QLatin1String("No module named 'PyPDF2"))) {
+            emit converterError(ConvError::NoPyPDFMod);
+        } else {
+            qDebug() << "Erml2pdf worker failed:" << error;
+            emit converterError(ConvError::UnknownError);
+        }
+    }
+    mFile.setFileName( QString() );
+}
 
+void ReportLabPDFConverter::convertWithProcess(const QString& outputPath)
+{
     // findTrml2Pdf returns a list of command line parts for the converter, such as
     // /usr/bin/pyhton3 /usr/local/share/erml2pdf.py
     QStringList rmlbin = DefaultProvider::self()->findTrml2Pdf();
 
     if ( ! rmlbin.size() ) {
+      QApplication::restoreOverrideCursor();
       emit converterError(ConvError::TrmlToolFail);
+      return;
     }
 
-    QApplication::setOverrideCursor( QCursor( Qt::BusyCursor ) );
-
-
     // qDebug () << "Writing output to " << mFile.fileName();
 
     // check if we have etrml2pdf
@@ -78,7 +202,8 @@ void ReportLabPDFConverter::convert(const QString& sourceFile, const QString &ou
     const QString prg = rmlbin.at(0);
 
     if( haveErml ) {
-        args << sourceFile;
+        // erml2pdf.py reads the source from stdin with -
+        args << (_sourceFile.isEmpty() ? QStringLiteral("-") : _sourceFile);
 
         mFile.setFileName(outputPath);
         mOutputSize = 0;
@@ -94,10 +219,23 @@ void ReportLabPDFConverter::convert(const QString& sourceFile, const QString &ou
             mProcess->setArguments(args);
             mTargetStream.setDevice( &mFile );
 
+            connect(mProcess, &QProcess::started, this, [this]() {
+                traceSpan(QStringLiteral("Converter start"));
+                _traceStart = RenderTrace::self()->now();
+            });
+            _traceStart = RenderTrace::self()->now();
             mProcess->start( );
+            if (_sourceFile.isEmpty()) {
+                mProcess->write(_sourceData);
+                mProcess->closeWriteChannel();
+            }
         } else {
+            QApplication::restoreOverrideCursor();
             emit converterError(ConvError::TargetFileError);
         }
+    } else {
+        QApplication::restoreOverrideCursor();
+        emit converterError(ConvError::TrmlToolFail);
     }
 }
 
@@ -120,6 +258,7 @@ void ReportLabPDFConverter::trml2pdfFinished( int exitCode, QProcess::ExitStatus
         mFile.close();
     }
     Q_UNUSED(stat)
+    traceSpan(QStringLiteral("Conversion"));
     QApplication::restoreOverrideCursor();
 
     // qDebug () << "PDF Creation Process finished with status " << exitStatus;
@@ -128,10 +267,7 @@ void ReportLabPDFConverter::trml2pdfFinished( int exitCode, QProcess::ExitStatus
         QFileInfo fi(mFile.fileName());
         if( fi.exists() ) {
             emit docAvailable( mFile.fileName() );
-            if( mProcess) {
-                const QString rmlFile = mProcess->arguments().last(); // the file name of the temp rmlfile
-                QFile::remove(rmlFile); // remove the rmlFile
-            }
+            removeSourceFile();
         } else {
             emit  converterError(ConvError::TargetFileMissing);
         }
@@ -155,27 +291,130 @@ void ReportLabPDFConverter::trml2pdfFinished( int exitCode, QProcess::ExitStatus
 // ====================================================================
 
 WeasyPrintPDFConverter::WeasyPrintPDFConverter()
-    :PDFConverter()
+    :PDFConverter(),
+      _workerJobId(-1)
 {
 
 }
 
+ConverterWorkerPool *WeasyPrintPDFConverter::workerPool()
+{
+    static QPointer<ConverterWorkerPool> pool;
+
+    if (!pool && KraftSettings::self()->useConverterWorker()) {
+        const QString script = DefaultProvider::self()->locateKraftTool(QStringLiteral("weasyprintworker.py"));
+        if (!script.isEmpty()) {
+            // the pool lives as long as the application
+            pool = new ConverterWorkerPool(QStringLiteral("python3"), QStringList() << script,
+                                           KraftSettings::self()->converterWorkers(), qApp);
+        }
+    }
+    return pool;
+}
+
+QStringList WeasyPrintPDFConverter::baseUrls() const
+{
+    const QString styleSheet = DefaultProvider::self()->locateFile("reports/kraft.css");
+    QFileInfo styleFI(styleSheet);
+    const QString styleSheetDir = styleFI.canonicalPath();
+
+    QStringList urls;
+    urls << styleSheetDir;
+    if (!_templatePath.isEmpty() && _templatePath != styleSheetDir) {
+        urls << _templatePath;
+    }
+    return urls;
+}
+
 void WeasyPrintPDFConverter::convert(const QString& sourceFile, const QString& outputPath)
+{
+    _sourceFile = sourceFile;
+    _sourceData.clear();
+
+    startConversion(outputPath);
+}
+
+void WeasyPrintPDFConverter::convertData(const QByteArray& source, const QString& outputPath)
+{
+    _sourceFile.clear();
+    _sourceData = source;
+
+    startConversion(outputPath);
+}
+
+void WeasyPrintPDFConverter::startConversion(const QString& outputPath)
 {
     mErrors.clear();
+    mFile.setFileName(outputPath);
+
+    QApplication::setOverrideCursor( QCursor( Qt::BusyCursor ) );
 
+    ConverterWorkerPool *pool = workerPool();
+    if (pool && pool->isAvailable()) {
+        QJsonObject job;
+        addSource(job);
+        job.insert(QStringLiteral("output"), outputPath);
+        if (!_watermarkFile.isEmpty()) {
+            job.insert(QStringLiteral("watermarkMode"), _watermarkMode);
+            job.insert(QStringLiteral("watermarkFile"), _watermarkFile);
+        }
+        job.insert(QStringLiteral("baseUrls"), QJsonArray::fromStringList(baseUrls()));
+
+        connect(pool, &ConverterWorkerPool::jobFinished, this, &WeasyPrintPDFConverter::slotWorkerJobFinished);
+        _traceStart = RenderTrace::self()->now();
+        _workerJobId = pool->submit(job);
+        qDebug() << "Submitted job" << _workerJobId << "to the weasyprint worker";
+    } else {
+        convertWithProcess();
+    }
+}
+
+void WeasyPrintPDFConverter::slotWorkerJobFinished(int jobId, ConverterWorkerPool::Result result, const QString& error)
+{
+    if (jobId != _workerJobId) {
+        return;
+    }
+    disconnect(qobject_cast<ConverterWorkerPool*>(sender()), nullptr, this, nullptr);
+    _workerJobId = -1;
+
+    if (result == ConverterWorkerPool::Result::WorkerUnavailable) {
+        // fall back to one weasyprint process for this document
+        convertWithProcess();
+        return;
+    }
+
+    traceSpan(QStringLiteral("Worker conversion"));
+    QApplication::restoreOverrideCursor();
+
+    if (result == ConverterWorkerPool::Result::Success && QFileInfo::exists(mFile.fileName())) {
+        removeSourceFile();
+        _watermarkApplied = !_watermarkFile.isEmpty();
+        emit docAvailable(mFile.fileName());
+    } else if (result == ConverterWorkerPool::Result::Success) {
+        emit converterError(ConvError::TargetFileMissing);
+    } else {
+        mErrors = error;
+        if (mErrors.contains(QLatin1String("No module named 'PyPDF2"))) {
+            emit converterError(ConvError::NoPyPDFMod);
+        } else {
+            qDebug() << "Weasyprint worker failed:" << error;
+            emit converterError(ConvError::UnknownError);
+        }
+    }
+    mFile.setFileName( QString() );
+}
+
+void WeasyPrintPDFConverter::convertWithProcess()
+{
     const QString prg = DefaultProvider::self()->locateBinary("weasyprint");
-    const QString styleSheet = DefaultProvider::self()->locateFile("reports/kraft.css");
 
     QFileInfo prgInfo(prg);
     if ( ! prgInfo.exists() || ! prgInfo.isExecutable() ) {
+        QApplication::restoreOverrideCursor();
         emit converterError(ConvError::WeasyPrintNotFound);
+        return;
     }
 
-    mFile.setFileName(outputPath);
-
-    QApplication::setOverrideCursor( QCursor( Qt::BusyCursor ) );
-
     mProcess = new QProcess;
     connect(mProcess, &QProcess::readyReadStandardOutput, this, &WeasyPrintPDFConverter::slotReceivedStdout);
     connect(mProcess, &QProcess::readyReadStandardError,  this, &WeasyPrintPDFConverter::slotReceivedStderr);
@@ -183,16 +422,12 @@ void WeasyPrintPDFConverter::convert(const QString& sourceFile, const QString& o
             this, &WeasyPrintPDFConverter::weasyPrintFinished);
 
     QStringList args;
-    QFileInfo styleFI(styleSheet);
-    const QString styleSheetDir = styleFI.canonicalPath();
-
-    args << sourceFile;
+    // weasyprint reads the source from stdin with -
+    args << (_sourceFile.isEmpty() ? QStringLiteral("-") : _sourceFile);
     args << mFile.fileName();
-    args << "-u";
-    args << styleSheetDir;
-    if (!_templatePath.isEmpty() && _templatePath != styleSheetDir) {
+    for (const QString& url : baseUrls()) {
         args << "-u";
-        args << _templatePath;
+        args << url;
     }
 
     qDebug() << "Arguments for weasyprint:" << args;
@@ -200,9 +435,16 @@ void WeasyPrintPDFConverter::convert(const QString& sourceFile, const QString& o
     mProcess->setArguments(args);
     mOutput.clear();
 
+    connect(mProcess, &QProcess::started, this, [this]() {
+        traceSpan(QStringLiteral("Converter start"));
+        _traceStart = RenderTrace::self()->now();
+    });
+    _traceStart = RenderTrace::self()->now();
     mProcess->start( );
-
-
+    if (_sourceFile.isEmpty()) {
+        mProcess->write(_sourceData);
+        mProcess->closeWriteChannel();
+    }
 }
 
 void WeasyPrintPDFConverter::slotReceivedStdout( )
@@ -223,6 +465,7 @@ void WeasyPrintPDFConverter::weasyPrintFinished( int exitCode, QProcess::ExitSta
         mFile.close();
     }
     Q_UNUSED(stat)
+    traceSpan(QStringLiteral("Conversion"));
     QApplication::restoreOverrideCursor();
 
     // qDebug () << "PDF Creation Process finished with status " << exitStatus;
@@ -231,10 +474,7 @@ void WeasyPrintPDFConverter::weasyPrintFinished( int exitCode, QProcess::ExitSta
         QFileInfo fi(mFile.fileName());
         if( fi.exists() ) {
             emit docAvailable( mFile.fileName() );
-            if( mProcess) {
-                const QString htmlFile = mProcess->arguments().first(); // the file name of the temp rmlfile
-                QFile::remove(htmlFile); // remove the rmlFile
-            }
+            removeSourceFile();
         } else {
             emit  converterError(ConvError::TargetFileMissing);
         }
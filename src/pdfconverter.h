@@ -23,8 +23,10 @@
 #include <QProcess>
 #include <QDataStream>
 #include <QFile>
+#include <QJsonObject>
 
 #include "dbids.h"
+#include "converterworkerpool.h"
 
 class PDFConverter : public QObject
 {
@@ -46,6 +48,12 @@ public:
 
     virtual void convert(const QString& sourceFile, const QString& outputPath) = 0;
 
+    /*
+     * Converts a document source that is passed in memory. It is handed
+     * to the converter on its standard input, no temporary file is needed.
+     */
+    virtual void convertData(const QByteArray& source, const QString& outputPath) = 0;
+
     QString getErrors() { return mErrors; }
 
     /*
@@ -54,15 +62,52 @@ public:
      */
     void setTemplatePath(const QString& path) { _templatePath = path; }
 
+    /*
+     * Asks the converter to merge the watermark file in the given mode
+     * (see DocType::mergeIdent) in the same pass. Only converters that
+     * run on a worker can do that, check watermarkApplied() after the
+     * document is available.
+     */
+    void setWatermark(const QString& mode, const QString& file) { _watermarkMode = mode; _watermarkFile = file; }
+    bool watermarkApplied() const { return _watermarkApplied; }
+
+    /*
+     * The document ident and template name the RenderTrace spans of the
+     * converter are recorded with.
+     */
+    void setTraceInfo(const QString& ident, const QString& tmpl) { _traceIdent = ident; _traceTemplate = tmpl; }
+
 signals:
     void docAvailable(const QString& fileName);
     void converterError( ConvError );
 
 protected:
+    /*
+     * Adds the source file or data to a worker job.
+     */
+    void addSource(QJsonObject& job) const;
+    /*
+     * The source file of convert() was a temporary file that is removed
+     * after a successful conversion.
+     */
+    void removeSourceFile();
+    /*
+     * Records a RenderTrace span of the phase from _traceStart until now.
+     */
+    void traceSpan(const QString& phase);
+
     QString mErrors;
     QProcess *mProcess;
     QFile mFile;
+    QString _sourceFile;
+    QByteArray _sourceData;
     QString _templatePath;
+    QString _watermarkMode;
+    QString _watermarkFile;
+    bool _watermarkApplied;
+    QString _traceIdent;
+    QString _traceTemplate;
+    qint64 _traceStart;
 
 };
 
@@ -74,17 +119,30 @@ public:
     ReportLabPDFConverter();
 
     void convert(const QString& sourceFile, const QString& outputPath) override;
+    void convertData(const QByteArray& source, const QString& outputPath) override;
+
+    /*
+     * The pool of erml2pdf.py server mode processes shared by all converters.
+     * Returns nullptr if the worker is disabled or a custom converter is
+     * configured.
+     */
+    static ConverterWorkerPool *workerPool();
 
 private slots:
     void trml2pdfFinished( int exitCode, QProcess::ExitStatus stat);
     void slotReceivedStdout();
     void slotReceivedStderr();
+    void slotWorkerJobFinished(int jobId, ConverterWorkerPool::Result result, const QString& error);
 
 private:
+    void startConversion(const QString& outputPath);
+    void convertWithProcess(const QString& outputPath);
+
     QFile mFile;
 
     QDataStream mTargetStream;
     int mOutputSize;
+    int _workerJobId;
 };
 
 // ====================================================================
@@ -95,14 +153,27 @@ public:
     WeasyPrintPDFConverter();
 
     void convert(const QString& sourceFile, const QString& outputPath) override;
+    void convertData(const QByteArray& source, const QString& outputPath) override;
+
+    /*
+     * The pool of weasyprintworker.py processes shared by all converters.
+     * Returns nullptr if the worker is disabled or can not be found.
+     */
+    static ConverterWorkerPool *workerPool();
 
 private slots:
     void slotReceivedStdout();
     void slotReceivedStderr();
     void weasyPrintFinished(int exitCode, QProcess::ExitStatus stat);
+    void slotWorkerJobFinished(int jobId, ConverterWorkerPool::Result result, const QString& error);
 
 private:
+    void startConversion(const QString& outputPath);
+    void convertWithProcess();
+    QStringList baseUrls() const;
+
     QByteArray mOutput;
+    int _workerJobId;
 };
 
 #endif // PDFCONVERTER_H
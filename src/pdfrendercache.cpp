@@ -0,0 +1,121 @@
+/***************************************************************************
+         pdfrendercache.cpp - content addressed cache for rendered PDFs
+                             -------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by Klaas Freitag
+    email                : kraft@freisturz.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QDebug>
+
+#include "pdfrendercache.h"
+
+PdfRenderCache::PdfRenderCache(qint64 maxSize, const QString& dir)
+    : _dir(dir),
+      _maxSize(maxSize)
+{
+    if (_dir.isEmpty()) {
+        _dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/pdf");
+    }
+}
+
+QByteArray PdfRenderCache::key(const QString& source, const QStringList& files, const QString& extra)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(source.toUtf8());
+    hash.addData(extra.toUtf8());
+
+    for (const QString& f : files) {
+        // the name is part of the key, so that a missing file counts as well
+        hash.addData(f.toUtf8());
+        QFile file(f);
+        if (file.open(QIODevice::ReadOnly)) {
+            const QFileInfo fi(file);
+            hash.addData(QByteArray::number(fi.lastModified().toMSecsSinceEpoch()));
+            hash.addData(&file);
+        }
+    }
+    return hash.result().toHex();
+}
+
+QString PdfRenderCache::fileName(const QByteArray& key) const
+{
+    return QString("%1/%2.pdf").arg(_dir).arg(QString::fromLatin1(key));
+}
+
+QString PdfRenderCache::lookup(const QByteArray& key) const
+{
+    if (key.isEmpty()) {
+        return QString();
+    }
+    const QString file = fileName(key);
+
+    QFile f(file);
+    if (!f.open(QIODevice::ReadWrite)) {
+        return QString();
+    }
+    // the modification time is the last usage for the LRU eviction
+    f.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    f.close();
+
+    return file;
+}
+
+bool PdfRenderCache::store(const QByteArray& key, const QString& pdfFile)
+{
+    if (key.isEmpty() || _maxSize <= 0) {
+        return false;
+    }
+
+    QDir dir;
+    if (!dir.mkpath(_dir)) {
+        qDebug() << "Can not create PDF cache dir" << _dir;
+        return false;
+    }
+
+    // copy to a temporary name first to never expose a half written file
+    const QString target = fileName(key);
+    const QString tmp = target + QStringLiteral(".part");
+    QFile::remove(tmp);
+    if (!QFile::copy(pdfFile, tmp)) {
+        return false;
+    }
+    QFile::remove(target);
+    if (!QFile::rename(tmp, target)) {
+        QFile::remove(tmp);
+        return false;
+    }
+
+    evict();
+    return true;
+}
+
+void PdfRenderCache::evict()
+{
+    QDir dir(_dir);
+    // sorted by modification time, the most recently used first
+    const QFileInfoList entries = dir.entryInfoList(QStringList() << QStringLiteral("*.pdf"),
+                                                    QDir::Files, QDir::Time);
+    qint64 size = 0;
+    for (const QFileInfo& fi : entries) {
+        size += fi.size();
+        if (size > _maxSize) {
+            QFile::remove(fi.absoluteFilePath());
+        }
+    }
+}
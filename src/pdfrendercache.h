@@ -0,0 +1,61 @@
+/***************************************************************************
+          pdfrendercache.h - content addressed cache for rendered PDFs
+                             -------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by Klaas Freitag
+    email                : kraft@freisturz.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef PDFRENDERCACHE_H
+#define PDFRENDERCACHE_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+/**
+ * Stores rendered PDF files under a hash of everything that went into
+ * them: The expanded template source and the content and modification
+ * time of the template, stylesheet and watermark files.
+ *
+ * The cache directory is limited in size. If it grows beyond, the least
+ * recently used files are removed. A lookup marks the file as used.
+ */
+class PdfRenderCache
+{
+public:
+    /*
+     * dir defaults to the application's cache location, maxSize in bytes.
+     */
+    explicit PdfRenderCache(qint64 maxSize, const QString& dir = QString());
+
+    static QByteArray key(const QString& source, const QStringList& files, const QString& extra = QString());
+
+    /*
+     * returns the file name of the cached PDF for the key, or an empty
+     * string if it is not in the cache.
+     */
+    QString lookup(const QByteArray& key) const;
+
+    bool store(const QByteArray& key, const QString& pdfFile);
+
+    QString directory() const { return _dir; }
+
+private:
+    QString fileName(const QByteArray& key) const;
+    void evict();
+
+    QString _dir;
+    qint64 _maxSize;
+};
+
+#endif // PDFRENDERCACHE_H
@@ -27,12 +27,14 @@
 
 #include <QDebug>
 #include <QDialogButtonBox>
+#include <QMessageBox>
 
 #include <klocalizedstring.h>
 
 #include "defaultprovider.h"
 #include "impviewwidgets.h"
 #include "geld.h"
+#include "templkatalog.h"
 #include "defaultprovider.h"
 
 #include "prefswages.h"
@@ -112,7 +114,17 @@ PrefsWages::~PrefsWages()
 
 void PrefsWages::save()
 {
+  // the stored template prices depend on the changed rates
+  QList<dbID> changed;
+  for( int row = 0; row < mWagesModel->rowCount(); row++ ) {
+    if( mWagesModel->isDirty(mWagesModel->index(row, 2)) ) {
+      changed.append(dbID(mWagesModel->data(mWagesModel->index(row, 0)).toInt()));
+    }
+  }
+
   mWagesModel->submitAll();
+
+  TemplKatalog::hourRatesChanged(changed);
 }
 
 void PrefsWages::slotAddWage()
@@ -246,6 +258,20 @@ WagesEditDialog::WagesEditDialog( QAbstractItemModel *model, int row, QWidget *p
 
 void WagesEditDialog::accept()
 {
+  if( mRow > -1 ) {
+    const double oldWage = mModel->data(mModel->index(mRow, 2)).toDouble();
+    if( qAbs(oldWage - mBaseWidget->mWage->value()) > 0.001 ) {
+      const int cnt = TemplKatalog::rateUsage(dbID(mModel->data(mModel->index(mRow, 0)).toInt()));
+      if( cnt > 0 && QMessageBox::question( this, i18n("Change Wage"),
+                                            i18np("The price of one catalog template is calculated with this wage "
+                                                  "and will be updated. Change the wage?",
+                                                  "The prices of %1 catalog templates are calculated with this wage "
+                                                  "and will be updated. Change the wage?", cnt)
+                                            ) == QMessageBox::No ) {
+        return;
+      }
+    }
+  }
   mapper->submit();
   QDialog::accept();
 }
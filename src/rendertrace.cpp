@@ -0,0 +1,185 @@
+/***************************************************************************
+         rendertrace.cpp - timing of the document render pipeline
+                             -------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by Klaas Freitag
+    email                : kraft@freisturz.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QSaveFile>
+#include <QDebug>
+
+#include "rendertrace.h"
+
+Q_GLOBAL_STATIC(RenderTrace, mSelf)
+
+RenderTrace *RenderTrace::self()
+{
+    return mSelf;
+}
+
+RenderTrace::RenderTrace()
+    : _enabled(0),
+      _maxSpans(10000),
+      _next(0)
+{
+    _timer.start();
+}
+
+void RenderTrace::setEnabled(bool on)
+{
+    _enabled.store(on ? 1 : 0);
+}
+
+qint64 RenderTrace::now() const
+{
+    if (!isEnabled()) {
+        return -1;
+    }
+    return _timer.nsecsElapsed() / 1000;
+}
+
+void RenderTrace::addSpan(const QString& phase, const QString& ident, const QString& tmpl, qint64 start)
+{
+    if (start < 0 || !isEnabled()) {
+        return;
+    }
+    Span span;
+    span.phase = phase;
+    span.ident = ident;
+    span.tmpl = QFileInfo(tmpl).fileName();
+    span.start = start;
+    span.duration = _timer.nsecsElapsed() / 1000 - start;
+
+    QMutexLocker lock(&_mutex);
+    Sum& s = _sums[span.phase];
+    s.count++;
+    s.total += span.duration;
+    s.max = qMax(s.max, span.duration);
+    _idents.insert(span.ident);
+
+    if (_spans.size() < _maxSpans) {
+        _spans.append(span);
+    } else {
+        _spans[_next] = span;
+        _next = (_next + 1) % _maxSpans;
+    }
+}
+
+void RenderTrace::setMaxSpans(int spans)
+{
+    QMutexLocker lock(&_mutex);
+    QVector<Span> kept = orderedSpans();
+    _maxSpans = qMax(1, spans);
+    if (kept.size() > _maxSpans) {
+        kept.remove(0, kept.size() - _maxSpans);
+    }
+    _spans = kept;
+    _next = 0;
+}
+
+// the kept spans from the oldest to the latest, called with the mutex locked
+QVector<RenderTrace::Span> RenderTrace::orderedSpans() const
+{
+    QVector<Span> re;
+    re.reserve(_spans.size());
+    for (int i = 0; i < _spans.size(); i++) {
+        re.append(_spans.at((_next + i) % _spans.size()));
+    }
+    return re;
+}
+
+bool RenderTrace::writeChromeTrace(const QString& fileName) const
+{
+    QJsonArray events;
+    {
+        QMutexLocker lock(&_mutex);
+        // one row per document in the trace viewer
+        QHash<QString, int> rows;
+        const qint64 pid = QCoreApplication::applicationPid();
+
+        for (const Span& span : orderedSpans()) {
+            auto row = rows.constFind(span.ident);
+            if (row == rows.constEnd()) {
+                row = rows.insert(span.ident, rows.size() + 1);
+            }
+            QJsonObject args;
+            args.insert(QStringLiteral("ident"), span.ident);
+            args.insert(QStringLiteral("template"), span.tmpl);
+
+            QJsonObject event;
+            event.insert(QStringLiteral("name"), span.phase);
+            event.insert(QStringLiteral("cat"), QStringLiteral("render"));
+            event.insert(QStringLiteral("ph"), QStringLiteral("X"));
+            event.insert(QStringLiteral("ts"), span.start);
+            event.insert(QStringLiteral("dur"), span.duration);
+            event.insert(QStringLiteral("pid"), pid);
+            event.insert(QStringLiteral("tid"), row.value());
+            event.insert(QStringLiteral("args"), args);
+            events.append(event);
+        }
+    }
+
+    QJsonObject trace;
+    trace.insert(QStringLiteral("traceEvents"), events);
+    trace.insert(QStringLiteral("displayTimeUnit"), QStringLiteral("ms"));
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Can not write the render trace to" << fileName;
+        return false;
+    }
+    file.write(QJsonDocument(trace).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
+
+QString RenderTrace::summary() const
+{
+    QMap<QString, Sum> sums;
+    int documents = 0;
+    {
+        QMutexLocker lock(&_mutex);
+        sums = _sums;
+        documents = _idents.size();
+    }
+
+    QString re = QString("Render timing of %1 documents:\n").arg(documents);
+    re += QString("%1 %2 %3 %4 %5\n").arg(QStringLiteral("Phase"), -20)
+            .arg(QStringLiteral("Count"), 7).arg(QStringLiteral("Total ms"), 11)
+            .arg(QStringLiteral("Avg ms"), 9).arg(QStringLiteral("Max ms"), 9);
+    QMapIterator<QString, Sum> it(sums);
+    while (it.hasNext()) {
+        it.next();
+        const Sum& s = it.value();
+        re += QString("%1 %2 %3 %4 %5\n").arg(it.key(), -20).arg(s.count, 7)
+                .arg(s.total / 1000.0, 11, 'f', 1)
+                .arg(s.total / 1000.0 / s.count, 9, 'f', 1)
+                .arg(s.max / 1000.0, 9, 'f', 1);
+    }
+    return re;
+}
+
+void RenderTrace::clear()
+{
+    QMutexLocker lock(&_mutex);
+    _spans.clear();
+    _next = 0;
+    _sums.clear();
+    _idents.clear();
+}
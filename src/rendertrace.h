@@ -0,0 +1,112 @@
+/***************************************************************************
+          rendertrace.h - timing of the document render pipeline
+                             -------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by Klaas Freitag
+    email                : kraft@freisturz.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef RENDERTRACE_H
+#define RENDERTRACE_H
+
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+/**
+ * Records how long the phases of rendering a document take, such as
+ * loading the archived document, expanding the template or running the
+ * converter. Every span carries the document ident and the template name.
+ *
+ * The spans can be written as Chrome trace JSON, to be loaded in
+ * chrome://tracing or Perfetto, and summed up per phase as a table.
+ *
+ * Only the latest spans are kept for the trace, the summary is summed up
+ * while recording, so a long session does not grow the memory.
+ *
+ * Recording is off by default and switched per instance, the application
+ * uses the one returned by self(). If it is disabled, now() returns -1
+ * and addSpan() returns right away, so the instrumentation costs just
+ * one atomic load per phase.
+ */
+class RenderTrace
+{
+public:
+    RenderTrace();
+
+    static RenderTrace *self();
+
+    bool isEnabled() const { return _enabled.load() != 0; }
+    void setEnabled(bool on);
+
+    /*
+     * The start time for a span in microseconds, or -1 if recording is
+     * disabled.
+     */
+    qint64 now() const;
+
+    /*
+     * Records a span of the phase that started at start and ends now.
+     * Spans with a negative start are ignored.
+     */
+    void addSpan(const QString& phase, const QString& ident, const QString& tmpl, qint64 start);
+
+    /*
+     * The amount of spans kept for writeChromeTrace, older spans are
+     * dropped. The summary covers all spans. Defaults to 10000.
+     */
+    void setMaxSpans(int spans);
+
+    bool writeChromeTrace(const QString& fileName) const;
+
+    /*
+     * Table with the count, total, average and maximum duration per phase.
+     */
+    QString summary() const;
+
+    void clear();
+
+private:
+    struct Span {
+        QString phase;
+        QString ident;
+        QString tmpl;
+        qint64 start;
+        qint64 duration;
+    };
+
+    struct Sum {
+        int count = 0;
+        qint64 total = 0;
+        qint64 max = 0;
+    };
+
+    QVector<Span> orderedSpans() const;
+
+    QAtomicInt _enabled;
+    QElapsedTimer _timer;
+    mutable QMutex _mutex;
+
+    // ring buffer, _next is the oldest span once it is full
+    QVector<Span> _spans;
+    int _maxSpans;
+    int _next;
+
+    QMap<QString, Sum> _sums;
+    QSet<QString> _idents;
+};
+
+#endif // RENDERTRACE_H
@@ -28,6 +28,7 @@
 #include <QMessageBox>
 #include <QDebug>
 #include <QUrl>
+#include <QDir>
 
 #include <KLocalizedString>
 
@@ -37,6 +38,7 @@
 #include "unitmanager.h"
 #include "dbids.h"
 #include "kraftsettings.h"
+#include "rendertrace.h"
 #include "docposition.h"
 #include "einheit.h"
 #include "archiveman.h"
@@ -49,6 +51,7 @@
 #include "grantleetemplate.h"
 #include "documenttemplate.h"
 #include "pdfconverter.h"
+#include "pdfrendercache.h"
 
 namespace {
 QString saveToTempFile( const QString& doc )
@@ -84,16 +87,18 @@ QString saveToTempFile( const QString& doc )
 
 ReportGenerator::ReportGenerator()
     : _useGrantlee(true),
-      mProcess(nullptr)
+      _customerLookup(true),
+      _traceStart(-1),
+      mProcess(nullptr),
+      mAddressProvider(nullptr)
 {
-  mAddressProvider = new AddressProvider(this);
-  connect(mAddressProvider, &AddressProvider::lookupResult,
-          this, &ReportGenerator::slotAddresseeFound);
 }
 
 ReportGenerator::~ReportGenerator()
 {
   // qDebug () << "ReportGen is destroyed!";
+  // a merger that is still running, e.g. if the batch renderer gave up
+  delete mProcess;
 }
 
 /*
@@ -116,10 +121,12 @@ void ReportGenerator::createDocument( ReportFormat format, const QString& docID,
 
     // now the addressee search through the address provider is finished.
     // Rendering can be started.
+    const qint64 loadStart = RenderTrace::self()->now();
     _archDoc.loadFromDb(archId);
 
     // the next call also sets the watermark options
     _tmplFile = findTemplateFile( _archDoc.docTypeStr() );
+    traceSpan(QStringLiteral("ArchDoc load"), loadStart);
 
     if ( _tmplFile.isEmpty() ) {
         qDebug () << "tmplFile is empty, exit reportgenerator!";
@@ -135,8 +142,15 @@ void ReportGenerator::lookupCustomerAddress()
 {
     const QString clientUid = _archDoc.clientUid();
     KContacts::Addressee contact;
-
-    if( ! clientUid.isEmpty() ) {
+    _traceStart = RenderTrace::self()->now();
+
+    if( _customerLookup && ! clientUid.isEmpty() ) {
+        // the address provider is created on demand as it starts the address backend
+        if (!mAddressProvider) {
+            mAddressProvider = new AddressProvider(this);
+            connect(mAddressProvider, &AddressProvider::lookupResult,
+                    this, &ReportGenerator::slotAddresseeFound);
+        }
         AddressProvider::LookupState state = mAddressProvider->lookupAddressee( clientUid );
         switch( state ) {
         case AddressProvider::LookupFromCache:
@@ -159,6 +173,7 @@ void ReportGenerator::lookupCustomerAddress()
 
 void ReportGenerator::slotAddresseeFound( const QString&, const KContacts::Addressee& contact )
 {
+    traceSpan(QStringLiteral("Address lookup"), _traceStart);
     mCustomerContact = contact;
     // now the three pillars archDoc, myContact and mCustomerContact are defined.
 
@@ -184,90 +199,175 @@ void ReportGenerator::slotAddresseeFound( const QString&, const KContacts::Addre
     }
 
     converter->setTemplatePath(fi.path());
+    converter->setTraceInfo(mDocId, _tmplFile);
 
     // expand the template...
+    const qint64 expandStart = RenderTrace::self()->now();
     const QString expanded = templateEngine->expand(&_archDoc, myContact, mCustomerContact);
+    traceSpan(QStringLiteral("Template expansion"), expandStart);
 
     if (expanded.isEmpty()) {
         emit failure(i18n("The template conversion failed."));
         delete converter;
         return;
     }
-    // ... and save to a tempoarary file
-    const QString tempFile = saveToTempFile(expanded);
-
-    if (tempFile.isEmpty()) {
-        emit failure(i18n("Saving to temporar file failed."));
-        delete converter;
-        return;
-    }
-
-    QString fullOutputPath = targetFileName();
+    const QString fullOutputPath = targetFileName();
 
     if (mMergeIdent == "1" || mMergeIdent == "2") {
         // check if the watermark file exists
         QFileInfo fi(mWatermarkFile);
         if (!mWatermarkFile.isEmpty() && fi.isReadable()) {
-            QTemporaryFile tmpFile;
-            tmpFile.open();
-            tmpFile.close();
-
-            // PDF merge is required. Write to temp file
-            fullOutputPath = tmpFile.fileName() + QStringLiteral(".pdf");
+            // the converter merges the watermark in the same pass if it can
+            converter->setWatermark(mMergeIdent, mWatermarkFile);
         } else {
             mMergeIdent = "0";
             qDebug() << "Can not read watermark file, generating without" << mWatermarkFile;
         }
     }
 
+    // look up the render cache with everything that influences the PDF
+    _cacheKey.clear();
+    const qint64 cacheSize = qint64(KraftSettings::self()->pdfCacheSize()) * 1024 * 1024;
+    if (cacheSize > 0) {
+        QStringList deps;
+        deps << _tmplFile;
+        if (qobject_cast<WeasyPrintPDFConverter*>(converter)) {
+            deps << DefaultProvider::self()->locateFile("reports/kraft.css");
+        }
+        if (mMergeIdent == "1" || mMergeIdent == "2") {
+            deps << mWatermarkFile;
+        }
+        const qint64 cacheStart = RenderTrace::self()->now();
+        _cacheKey = PdfRenderCache::key(expanded, deps, mMergeIdent);
+
+        PdfRenderCache cache(cacheSize);
+        const QString cachedPdf = cache.lookup(_cacheKey);
+        traceSpan(QStringLiteral("PDF cache lookup"), cacheStart);
+        if (!cachedPdf.isEmpty()) {
+            QFile::remove(fullOutputPath);
+            if (QFile::copy(cachedPdf, fullOutputPath)) {
+                qDebug() << "Using cached PDF" << cachedPdf;
+                delete converter;
+                emit docAvailable(_requestedFormat, fullOutputPath, mCustomerContact);
+                return;
+            }
+        }
+    }
+
+    QString tempFile;
+    if (KraftSettings::self()->converterTempFiles()) {
+        // ... and save to a tempoarary file
+        const qint64 writeStart = RenderTrace::self()->now();
+        tempFile = saveToTempFile(expanded);
+        traceSpan(QStringLiteral("Temp file write"), writeStart);
+
+        if (tempFile.isEmpty()) {
+            emit failure(i18n("Saving to temporar file failed."));
+            delete converter;
+            return;
+        }
+    }
+
     // Now there is the completed, expanded document source.
     connect( converter, &PDFConverter::docAvailable,
              this, &ReportGenerator::slotPdfDocAvailable);
     connect( converter, &PDFConverter::converterError,
              this, &ReportGenerator::slotConverterError);
-    converter->convert(tempFile, fullOutputPath);
+    if (tempFile.isEmpty()) {
+        // the source is handed to the converter directly
+        converter->convertData(expanded.toUtf8(), fullOutputPath);
+    } else {
+        converter->convert(tempFile, fullOutputPath);
+    }
 
 }
 
 void ReportGenerator::slotPdfDocAvailable(const QString& file)
 {
-    QObject *s = sender();
+    PDFConverter *converter = qobject_cast<PDFConverter*>(sender());
     qDebug() << "The document is finished!:" << file;
 
-    s->deleteLater();
+    const bool watermarkDone = converter && converter->watermarkApplied();
+    if (converter) {
+        converter->deleteLater();
+    }
+
     // check for the watermark requirements
-    if (mMergeIdent == "1" || mMergeIdent == "2") {
-        // check if the watermark file exists
-        mergePdfWatermark(file);
+    if ((mMergeIdent == "1" || mMergeIdent == "2") && !watermarkDone) {
+        // The converter could not merge the watermark. Move the document
+        // aside, the merger writes the final target file.
+        QTemporaryFile tmpFile;
+        tmpFile.open();
+        tmpFile.close();
+        const QString unmerged = tmpFile.fileName() + QStringLiteral(".pdf");
+
+        if (QFile::rename(file, unmerged)) {
+            mergePdfWatermark(unmerged);
+        } else {
+            slotConverterError(PDFConverter::ConvError::PDFMergerError);
+        }
     } else {
-        emit docAvailable(_requestedFormat, file, mCustomerContact);
+        finishDocument(file);
     }
 }
 
+void ReportGenerator::traceSpan(const QString& phase, qint64 start) const
+{
+    RenderTrace::self()->addSpan(phase, mDocId, _tmplFile, start);
+}
+
+void ReportGenerator::finishDocument(const QString& file)
+{
+    if (!_cacheKey.isEmpty()) {
+        PdfRenderCache cache(qint64(KraftSettings::self()->pdfCacheSize()) * 1024 * 1024);
+        cache.store(_cacheKey, file);
+    }
+    emit docAvailable(_requestedFormat, file, mCustomerContact);
+}
+
 void ReportGenerator::mergePdfWatermark(const QString& file)
 {
+    _traceStart = RenderTrace::self()->now();
+
+    const QString prg = DefaultProvider::self()->locateKraftTool(QStringLiteral("watermarkpdf.py"));
+    if (prg.isEmpty()) {
+        qDebug() << "The watermark merger watermarkpdf.py can not be found";
+        QFile::remove(file);
+        emit failure(i18n("The PDF merger utility watermarkpdf.py can not be found."));
+        return;
+    }
+
     mProcess = new QProcess();
     connect(mProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
             this, &ReportGenerator::pdfMergeFinished);
+    connect(mProcess, &QProcess::errorOccurred, this, &ReportGenerator::pdfMergeError);
 
-    const QString prg = DefaultProvider::self()->locateKraftTool(QStringLiteral("watermarkpdf.py"));
-    if (!prg.isEmpty()) {
-        mProcess->setProgram( QStringLiteral("python3") );
-        QStringList args;
-        args << prg;
-        args << QStringLiteral("-m") << mMergeIdent;
-        args << QStringLiteral("-o") << targetFileName();
-        args << mWatermarkFile;
-        args << file;
-
-        mProcess->setArguments(args);
-
-        mProcess->start( );
+    mProcess->setProgram( QStringLiteral("python3") );
+    QStringList args;
+    args << prg;
+    args << QStringLiteral("-m") << mMergeIdent;
+    args << QStringLiteral("-o") << targetFileName();
+    args << mWatermarkFile;
+    args << file;
+
+    mProcess->setArguments(args);
+
+    mProcess->start( );
+}
+
+void ReportGenerator::pdfMergeError(QProcess::ProcessError error)
+{
+    // all other errors are followed by finished
+    if (error == QProcess::FailedToStart) {
+        qDebug() << "The watermark merger can not be started:" << mProcess->errorString();
+        QFile::remove(mProcess->arguments().last());
+        slotConverterError(PDFConverter::ConvError::PDFMergerError);
     }
 }
 
 void ReportGenerator::pdfMergeFinished(int exitCode, QProcess::ExitStatus exitStatus)
 {
+    traceSpan(QStringLiteral("Watermark merge"), _traceStart);
     if (exitStatus == QProcess::ExitStatus::NormalExit && exitCode == 0) {
         const QString fileName = targetFileName();
 
@@ -275,7 +375,7 @@ void ReportGenerator::pdfMergeFinished(int exitCode, QProcess::ExitStatus exitSt
         QFile::remove(tmpFile);
         mProcess->deleteLater();
         mProcess = nullptr;
-        emit docAvailable(_requestedFormat, fileName, mCustomerContact);
+        finishDocument(fileName);
     } else {
         slotConverterError(PDFConverter::ConvError::PDFMergerError);
     }
@@ -320,12 +420,19 @@ void ReportGenerator::slotConverterError(PDFConverter::ConvError err)
         break;
     }
     emit failure(errMsg);
-    s->deleteLater();
+    if (s) {
+        s->deleteLater();
+    }
 }
 
 QString ReportGenerator::targetFileName() const
 {
     ArchDocDigest dig = _archDoc.toDigest();
+    if (!_outputDir.isEmpty()) {
+        const QString filename = ArchiveMan::self()->archiveFileName(dig.archDocIdent(),
+                                                                     dig.archDocId().toString(), "pdf");
+        return QDir(_outputDir).filePath(filename);
+    }
     return dig.pdfArchiveFileName();
 }
 
@@ -54,11 +54,24 @@ public slots:
 
     void setMyContact( const KContacts::Addressee& );
 
+    /*
+     * If disabled, the customer contact is not looked up in the address
+     * book and the address backend is not started at all. Used for headless
+     * rendering. Enabled by default.
+     */
+    void setCustomerLookup(bool lookup) { _customerLookup = lookup; }
+
+    /*
+     * Write the PDF into this directory instead of the PDF archive dir.
+     */
+    void setOutputDir(const QString& dir) { _outputDir = dir; }
+
 private slots:
     void slotPdfDocAvailable(const QString& file);
     void slotConverterError(PDFConverter::ConvError err);
     void mergePdfWatermark(const QString &file);
     void pdfMergeFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void pdfMergeError(QProcess::ProcessError error);
 
 private:
     QString findTemplateFile( const QString& );
@@ -80,12 +93,18 @@ private:
     QString registerTag( const QString&, const QString& ) const;
     QString registerDictTag( const QString&, const QString&, const QString& ) const;
     QString targetFileName() const;
+    void finishDocument(const QString& file);
+    void traceSpan(const QString& phase, qint64 start) const;
 
     QString escapeTrml2pdfXML( const QString& str ) const;
 
     QString rmlString( const QString& str, const QString& paraStyle = QString() ) const;
 
     bool _useGrantlee;
+    bool _customerLookup;
+    QString _outputDir;
+    QByteArray _cacheKey;
+    qint64 _traceStart;
 
     QString   mErrors;
     QString   mMergeIdent;
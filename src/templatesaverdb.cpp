@@ -366,6 +366,17 @@ void TemplateSaverDB::fillTemplateBuffer( QSqlRecord *buffer, FloskelTemplate *t
     if( isNew ) {
         buffer->setValue( "enterDatum", dtString);
         tmpl->setEnterDate( dt );
+
+        // behind the last template of the chapter
+        QSqlQuery q;
+        q.prepare( "SELECT MAX(sortKey) FROM Catalog WHERE chapterID=:chap" );
+        q.bindValue( ":chap", tmpl->chapterId().toInt() );
+        int key = 0;
+        if( q.exec() && q.next() ) {
+            key = q.value(0).toInt();
+        }
+        tmpl->setSortKey( key + CatalogTemplate::SortKeyGap );
+        buffer->setValue( "sortKey", tmpl->sortKey() );
     }
     buffer->setValue("modifyDatum", dtString );
     tmpl->setModifyDate( dt );
@@ -377,6 +388,17 @@ void TemplateSaverDB::fillTemplateBuffer( QSqlRecord *buffer, FloskelTemplate *t
     }
     buffer->setValue( "Preisart", ctype );
     buffer->setValue( "EPreis", tmpl->manualPrice().toDouble() );
+
+    // the price of the calculation, read by the catalog instead of loading
+    // all calculation parts
+    if( ctype == 1 ) {
+        buffer->setValue( "calcPrice", QVariant() );
+        tmpl->clearStoredPrice();
+    } else {
+        const Geld price = tmpl->unitPrice();
+        buffer->setValue( "calcPrice", price.toDouble() );
+        tmpl->setStoredPrice( price );
+    }
 }
 
 void TemplateSaverDB::saveTemplateChapter( FloskelTemplate* tmpl )
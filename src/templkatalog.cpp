@@ -16,11 +16,18 @@
  ***************************************************************************/
 
 #include <QObject>
+#include <QHash>
+#include <QSqlDatabase>
+#include <QSqlError>
 #include <QSqlQuery>
 #include <QStringList>
 #include <qdom.h>
 #include <QFile>
 #include <QDir>
+#include <QFileInfo>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QSaveFile>
 
 #include <QDebug>
 #include <QFileDialog>
@@ -35,16 +42,39 @@
 #include "timecalcpart.h"
 #include "fixcalcpart.h"
 #include "materialcalcpart.h"
+#include "matkatalog.h"
 #include "geld.h"
 #include "katalog.h"
+#include "katalogman.h"
 
 /** constructor of a katalog, which is only a list of Floskel templates.
  *  A name must be given, which is displayed for the root element in the
  *
  */
 
+namespace {
+
+const quint32 SnapshotMagic = 0x4B434154; // "KCAT"
+// increase if the content of the snapshot changes
+const quint32 SnapshotVersion = 1;
+
+void addQueryResult( QCryptographicHash& hash, QSqlQuery& q )
+{
+  q.exec();
+  if( q.next() ) {
+    for( int i = 0; i < q.record().count(); i++ ) {
+      hash.addData( q.value(i).toString().toUtf8() );
+      hash.addData( "|", 1 );
+    }
+  }
+}
+
+}
+
 TemplKatalog::TemplKatalog( const QString& name )
-    : Katalog( name )
+    : Katalog( name ),
+      mDependenciesLoaded(false),
+      mChapterIndexValid(false)
 {
 
 }
@@ -67,7 +97,7 @@ void TemplKatalog::reload( dbID id)
 
   if(templ)
   {
-    QSqlQuery q("SELECT unitID, TemplID, chapterID, Preisart, EPreis, modifyDatum, enterDatum, Floskel, Gewinn, zeitbeitrag FROM Catalog WHERE TemplID=:TemplID");
+    QSqlQuery q("SELECT unitID, TemplID, chapterID, Preisart, EPreis, modifyDatum, enterDatum, Floskel, Gewinn, zeitbeitrag, calcPrice FROM Catalog WHERE TemplID=:TemplID");
     q.bindValue(":TemplID", id.toInt());
     q.exec();
 
@@ -76,19 +106,508 @@ void TemplKatalog::reload( dbID id)
       //templ->setEinheitId(q.value(0).toInt());
       // qDebug() << "Reloading template number " << q.value(1) << endl;
       templ->setChapterId(dbID( q.value(2).toInt()), false );
+      mChapterIndexValid = false;
       //templ->setCalculationType(q.value(3).toInt());
       templ->setManualPrice(q.value(4).toDouble());
       templ->setText( q.value(7).toString() );
-      templ->setBenefit( q.value(8).toDouble());
       templ->setHasTimeslice( q.value(9).toBool() );
+      if( q.value(10).isNull() ) {
+        templ->clearStoredPrice();
+      } else {
+        templ->setStoredPrice( Geld(q.value(10).toDouble()) );
+      }
 
       templ->clearCalcParts();
       loadCalcParts( templ );
+      // the parts may use other rates and materials now
+      mDependenciesLoaded = false;
     }
   }
 }
 
+QString TemplKatalog::chapterIdList() const
+{
+  QString chapIdList {"0"};
+  for( const CatalogChapter& chap : mChapters ) {
+      chapIdList.append(",");
+      chapIdList.append(chap.id().toString());
+  }
+  return chapIdList;
+}
+
+/*
+ * Reads the templates and the usage counts with one query each. The
+ * calculation parts are loaded by the templates on first use, the
+ * catalog view only needs the stored unit price.
+ *
+ * Templates without a stored price, because they were never stored or
+ * a rate or material they use has changed, get their parts with one
+ * query per part table. Their computed prices are written back in one
+ * transaction.
+ */
 int TemplKatalog::load()
+{
+  const int cnt = loadTemplates();
+
+  QHash<int, FloskelTemplate*> templates;
+  templates.reserve(m_flosList.size());
+  QList<FloskelTemplate*> unpriced;
+  for( FloskelTemplate *flos : m_flosList ) {
+    templates.insert(flos->getTemplID(), flos);
+    if( flos->calcKind() != CatalogTemplate::ManualPrice && !flos->hasStoredPrice() ) {
+      unpriced.append(flos);
+    }
+  }
+
+  loadUsageCounts(templates);
+
+  if( !unpriced.isEmpty() ) {
+    storeCalcPrices(unpriced);
+  }
+
+  return cnt;
+}
+
+/*
+ * Loads the calculation parts of all templates in the list that do not
+ * have them yet, with one query per part table.
+ */
+void TemplKatalog::loadMissingCalcParts( const QList<FloskelTemplate*>& templates )
+{
+  QHash<int, FloskelTemplate*> unloaded;
+  QStringList ids;
+  for( FloskelTemplate *flos : templates ) {
+    if( !flos->calcPartsLoaded() ) {
+      flos->clearCalcParts();
+      unloaded.insert(flos->getTemplID(), flos);
+      ids.append(QString::number(flos->getTemplID()));
+    }
+  }
+  if( unloaded.isEmpty() ) {
+    return;
+  }
+  const QString cond = "c.TemplID IN( " + ids.join(",") + ")";
+
+  // same order of the part types as in loadCalcParts()
+  loadAllTimeCalcParts(unloaded, cond);
+  loadAllFixCalcParts(unloaded, cond);
+  loadAllMaterialCalcParts(unloaded, cond);
+}
+
+void TemplKatalog::storeCalcPrices( const QList<FloskelTemplate*>& templates )
+{
+  QSqlDatabase db = QSqlDatabase::database();
+  QList<QPair<FloskelTemplate*, Geld> > prices;
+  if( !db.transaction() || !writeCalcPrices(templates, &prices) || !db.commit() ) {
+    qDebug() << "Failed to store the calculated template prices:" << db.lastError().text();
+    db.rollback();
+    return;
+  }
+
+  for( const auto& p : prices ) {
+    p.first->setStoredPrice(p.second);
+  }
+}
+
+/*
+ * Writes the calculated prices of the templates within the transaction
+ * of the caller. The prices are returned instead of set, so that the
+ * templates only get them once the transaction is committed.
+ */
+bool TemplKatalog::writeCalcPrices( const QList<FloskelTemplate*>& templates,
+                                    QList<QPair<FloskelTemplate*, Geld> > *prices )
+{
+  loadMissingCalcParts(templates);
+
+  QSqlQuery q;
+  q.prepare("UPDATE Catalog SET calcPrice=:price WHERE TemplID=:TemplID");
+  for( FloskelTemplate *flos : templates ) {
+    const Geld price = flos->unitPrice();
+    q.bindValue(":price", price.toDouble());
+    q.bindValue(":TemplID", flos->getTemplID());
+    if( !q.exec() ) {
+      qDebug() << "Failed to store the price of template" << flos->getTemplID() << q.lastError().text();
+      return false;
+    }
+    prices->append(qMakePair(flos, price));
+  }
+  return true;
+}
+
+/*
+ * Reads which templates of the catalog use which hour rates and
+ * materials, without loading the calculation parts.
+ */
+void TemplKatalog::loadDependencies()
+{
+  mRateUsers.clear();
+  mMaterialUsers.clear();
+  mTemplatesById.clear();
+
+  for( FloskelTemplate *flos : m_flosList ) {
+    mTemplatesById.insert(flos->getTemplID(), flos);
+  }
+
+  const QString chapIdList = chapterIdList();
+  QSqlQuery q("SELECT DISTINCT t.stdHourSet, t.TemplID FROM CalcTime t JOIN Catalog c ON c.TemplID = t.TemplID"
+              " WHERE c.chapterID IN( " + chapIdList + ")");
+  q.exec();
+  while( q.next() ) {
+    mRateUsers.insert(q.value(0).toInt(), q.value(1).toInt());
+  }
+
+  q.exec("SELECT DISTINCT m.materialID, m.TemplID FROM CalcMaterials m JOIN Catalog c ON c.TemplID = m.TemplID"
+         " WHERE c.chapterID IN( " + chapIdList + ")");
+  while( q.next() ) {
+    mMaterialUsers.insert(q.value(0).toInt(), q.value(1).toInt());
+  }
+  mDependenciesLoaded = true;
+}
+
+QList<FloskelTemplate*> TemplKatalog::dependentTemplates( const QMultiHash<int, int>& users, int id ) const
+{
+  QList<FloskelTemplate*> re;
+  auto it = users.constFind(id);
+  while( it != users.constEnd() && it.key() == id ) {
+    FloskelTemplate *flos = mTemplatesById.value(it.value());
+    // manual prices do not depend on the calculation
+    if( flos && flos->calcKind() != CatalogTemplate::ManualPrice ) {
+      re.append(flos);
+    }
+    ++it;
+  }
+  return re;
+}
+
+QList<FloskelTemplate*> TemplKatalog::templatesUsingRate( dbID rateId )
+{
+  if( !mDependenciesLoaded ) {
+    loadDependencies();
+  }
+  return dependentTemplates(mRateUsers, rateId.toInt());
+}
+
+QList<FloskelTemplate*> TemplKatalog::templatesUsingMaterial( dbID materialId )
+{
+  if( !mDependenciesLoaded ) {
+    loadDependencies();
+  }
+  return dependentTemplates(mMaterialUsers, materialId.toInt());
+}
+
+QList<TemplKatalog*> TemplKatalog::loadedCatalogs()
+{
+  QList<TemplKatalog*> re;
+  for( Katalog *k : KatalogMan::self()->templateCatalogs() ) {
+    TemplKatalog *kat = static_cast<TemplKatalog*>(k);
+    if( !kat->m_flosList.isEmpty() ) {
+      re.append(kat);
+    }
+  }
+  return re;
+}
+
+/*
+ * All template catalogs use the same rates and materials, so the usage
+ * is counted over all catalogs, loaded or not.
+ */
+int TemplKatalog::rateUsage( dbID rateId )
+{
+  QSqlQuery q;
+  q.prepare("SELECT COUNT(DISTINCT t.TemplID) FROM CalcTime t JOIN Catalog c ON c.TemplID = t.TemplID"
+            " WHERE t.stdHourSet=:id AND c.Preisart <> 1");
+  q.bindValue(":id", rateId.toInt());
+  q.exec();
+  return q.next() ? q.value(0).toInt() : 0;
+}
+
+int TemplKatalog::materialUsage( dbID materialId )
+{
+  QSqlQuery q;
+  q.prepare("SELECT COUNT(DISTINCT m.TemplID) FROM CalcMaterials m JOIN Catalog c ON c.TemplID = m.TemplID"
+            " WHERE m.materialID=:id AND c.Preisart <> 1");
+  q.bindValue(":id", materialId.toInt());
+  q.exec();
+  return q.next() ? q.value(0).toInt() : 0;
+}
+
+/*
+ * Drops the stored prices of the templates that are not in one of the
+ * loaded catalogs, they are computed again when their catalog is loaded.
+ * partSelect selects the ids of the templates using the rate or material.
+ * Returns -1 on error.
+ */
+int TemplKatalog::dropStoredPrices( const QString& partSelect, const QList<TemplKatalog*>& loaded )
+{
+  QString sql = "UPDATE Catalog SET calcPrice=NULL WHERE Preisart <> 1 AND TemplID IN (" + partSelect + ")";
+  if( !loaded.isEmpty() ) {
+    QStringList chapIds;
+    for( TemplKatalog *kat : loaded ) {
+      chapIds.append( kat->chapterIdList() );
+    }
+    sql += " AND chapterID NOT IN (" + chapIds.join(',') + ")";
+  }
+
+  QSqlQuery q;
+  if( !q.exec(sql) ) {
+    qDebug() << q.executedQuery() << q.lastError();
+    return -1;
+  }
+  return q.numRowsAffected();
+}
+
+/*
+ * Drops the outdated stored prices and writes the new prices of the
+ * templates of the loaded catalogs in one transaction. Only after the
+ * commit the templates get their new stored prices.
+ */
+int TemplKatalog::changePrices( const QString& partSelect,
+                                const QHash<TemplKatalog*, QList<FloskelTemplate*> >& templates )
+{
+  QSqlDatabase db = QSqlDatabase::database();
+  if( !db.transaction() ) {
+    qDebug() << "Failed to start the price update:" << db.lastError().text();
+    return -1;
+  }
+
+  int cnt = dropStoredPrices(partSelect, templates.keys());
+  QList<QPair<FloskelTemplate*, Geld> > prices;
+  QHashIterator<TemplKatalog*, QList<FloskelTemplate*> > it(templates);
+  while( cnt >= 0 && it.hasNext() ) {
+    it.next();
+    if( !it.value().isEmpty() && !it.key()->writeCalcPrices(it.value(), &prices) ) {
+      cnt = -1;
+    }
+  }
+
+  if( cnt < 0 || !db.commit() ) {
+    qDebug() << "Failed to update the template prices:" << db.lastError().text();
+    db.rollback();
+    return -1;
+  }
+
+  for( const auto& p : prices ) {
+    p.first->setStoredPrice(p.second);
+  }
+  return cnt + prices.size();
+}
+
+/*
+ * Recomputes and stores the prices of the templates in the loaded
+ * catalogs that use the hour rate. The stored prices of the templates in
+ * the other catalogs are dropped and computed again on their next load.
+ * Returns the amount of affected templates.
+ */
+int TemplKatalog::hourRateChanged( dbID rateId )
+{
+  return hourRatesChanged( QList<dbID>() << rateId );
+}
+
+int TemplKatalog::hourRatesChanged( const QList<dbID>& rateIds )
+{
+  if( rateIds.isEmpty() ) {
+    return 0;
+  }
+
+  const QList<TemplKatalog*> catalogs = loadedCatalogs();
+  QHash<TemplKatalog*, QList<FloskelTemplate*> > templates;
+  for( TemplKatalog *kat : catalogs ) {
+    templates.insert(kat, QList<FloskelTemplate*>());
+  }
+
+  QStringList ids;
+  for( const dbID& rateId : rateIds ) {
+    ids.append(QString::number(rateId.toInt()));
+
+    StdSatz rate = StdSatzMan::self()->getStdSatz(rateId);
+    for( TemplKatalog *kat : catalogs ) {
+      QList<FloskelTemplate*>& list = templates[kat];
+      for( FloskelTemplate *flos : kat->templatesUsingRate(rateId) ) {
+        if( !list.contains(flos) ) {
+          list.append(flos);
+        }
+
+        // loaded time parts keep a copy of the rate
+        if( !flos->calcPartsLoaded() ) continue;
+        for( CalcPart *cp : flos->getCalcPartsList(KALKPART_TIME) ) {
+          TimeCalcPart *tcp = static_cast<TimeCalcPart*>(cp);
+          if( tcp->getStundensatz().getId() == rateId ) {
+            const bool dirty = tcp->isDirty();
+            tcp->setStundensatz(rate);
+            tcp->setDirty(dirty);
+          }
+        }
+      }
+    }
+  }
+
+  return changePrices("SELECT TemplID FROM CalcTime WHERE stdHourSet IN (" + ids.join(',') + ")", templates);
+}
+
+/*
+ * Same as hourRateChanged() for a material. The material calculation
+ * parts share the material object, which has the new price already.
+ */
+int TemplKatalog::materialChanged( dbID materialId )
+{
+  QHash<TemplKatalog*, QList<FloskelTemplate*> > templates;
+  for( TemplKatalog *kat : loadedCatalogs() ) {
+    templates.insert(kat, kat->templatesUsingMaterial(materialId));
+  }
+
+  return changePrices(QString("SELECT TemplID FROM CalcMaterials WHERE materialID=%1").arg(materialId.toInt()),
+                      templates);
+}
+
+/*
+ * The former loader, which queries the usage and the calculation parts
+ * template by template. Much slower than load() for big catalogs, kept
+ * to verify load().
+ */
+int TemplKatalog::loadPerTemplate()
+{
+  const int cnt = loadTemplates();
+
+  for( FloskelTemplate *flos : m_flosList ) {
+    auto usage = usageCount(flos->getTemplID());
+    flos->setLastUsedDate(usage.second);
+    flos->setUseCounter(usage.first);
+
+    loadCalcParts( flos );
+  }
+  return cnt;
+}
+
+/*
+ * The chapters are hashed completely. The templates and the usage counts
+ * are summed up by the database, weighted by their ids, so that moving
+ * or reordering templates changes the key as well. Edited texts change
+ * the modification date.
+ */
+QByteArray TemplKatalog::snapshotKey()
+{
+  QCryptographicHash hash( QCryptographicHash::Sha1 );
+  hash.addData( QByteArray::number( SnapshotVersion ) );
+  hash.addData( QByteArray::number( id().toInt() ) );
+  hash.addData( m_description.toUtf8() );
+
+  const QList<CatalogChapter> chapters = getKatalogChapters( true );
+  for( const CatalogChapter& chap : chapters ) {
+    hash.addData( QString( "%1|%2|%3|%4|%5|" ).arg( chap.id().toInt() ).arg( chap.parentId().toInt() )
+                  .arg( chap.sortKey() ).arg( chap.name() ).arg( chap.description() ).toUtf8() );
+  }
+
+  QSqlQuery q;
+  q.prepare( "SELECT COUNT(*), SUM(TemplID), SUM(TemplID * chapterID), SUM(TemplID * sortKey), "
+             "SUM(TemplID * Preisart), SUM(TemplID * EPreis), SUM(TemplID * calcPrice), COUNT(calcPrice), "
+             "SUM(TemplID * zeitbeitrag), SUM(TemplID * unitID), SUM(TemplID * LENGTH(Floskel)), "
+             "MAX(modifyDatum), MAX(enterDatum) FROM Catalog WHERE chapterID IN( " + chapterIdList() + ")" );
+  addQueryResult( hash, q );
+
+  QSqlQuery u;
+  u.prepare( "SELECT COUNT(*), SUM(itemId * usageCount), MAX(lastUsed) FROM catItemUsage WHERE catId=:catId" );
+  u.bindValue( ":catId", id().toInt() );
+  addQueryResult( hash, u );
+
+  return hash.result().toHex();
+}
+
+bool TemplKatalog::loadSnapshot( const QString& fileName )
+{
+  QFile file( fileName );
+  if( !file.open( QIODevice::ReadOnly ) ) {
+    return false;
+  }
+
+  Katalog::load();
+  const QByteArray key = snapshotKey();
+
+  QDataStream in( &file );
+  in.setVersion( QDataStream::Qt_5_6 );
+  quint32 magic = 0;
+  quint32 version = 0;
+  QByteArray fileKey;
+  in >> magic >> version >> fileKey;
+  if( in.status() != QDataStream::Ok || magic != SnapshotMagic || version != SnapshotVersion || fileKey != key ) {
+    qDebug() << "Catalog snapshot" << fileName << "is outdated";
+    return false;
+  }
+
+  qint32 cnt = 0;
+  in >> cnt;
+  FloskelTemplateList templates;
+  for( int i = 0; i < cnt && in.status() == QDataStream::Ok; i++ ) {
+    qint32 templId, unitId, chapterId, calcKind, sortKey, useCounter;
+    QString text;
+    QDateTime entered, modified, lastUsed;
+    qint64 manualPrice, storedPrice;
+    bool timeslice, hasStoredPrice;
+
+    in >> templId >> unitId >> chapterId >> calcKind >> text >> entered >> modified
+       >> manualPrice >> timeslice >> hasStoredPrice >> storedPrice >> sortKey >> useCounter >> lastUsed;
+    if( in.status() != QDataStream::Ok ) {
+      break;
+    }
+
+    FloskelTemplate *flos = new FloskelTemplate( templId, text, unitId, chapterId, calcKind );
+    flos->setEnterDate( entered );
+    flos->setModifyDate( modified );
+    flos->setManualPrice( Geld( long( manualPrice ) ) );
+    flos->setHasTimeslice( timeslice );
+    if( hasStoredPrice ) {
+      flos->setStoredPrice( Geld( long( storedPrice ) ) );
+    }
+    flos->setSortKey( sortKey );
+    flos->setUseCounter( useCounter );
+    flos->setLastUsedDate( lastUsed );
+    templates.append( flos );
+  }
+
+  if( in.status() != QDataStream::Ok ) {
+    qDebug() << "Catalog snapshot" << fileName << "can not be read";
+    qDeleteAll( templates );
+    return false;
+  }
+
+  m_flosList = templates;
+  mDependenciesLoaded = false;
+  mChapterIndexValid = false;
+  for( FloskelTemplate *flos : m_flosList ) {
+    if( flos->useCounter() > 0 || flos->lastUsedDate().isValid() ) {
+      mUsage.insert( flos->getTemplID(), qMakePair( flos->useCounter(), flos->lastUsedDate() ) );
+    }
+  }
+  return true;
+}
+
+bool TemplKatalog::writeSnapshot( const QString& fileName )
+{
+  const QByteArray key = snapshotKey();
+
+  QDir dir;
+  if( !dir.mkpath( QFileInfo( fileName ).absolutePath() ) ) {
+    return false;
+  }
+  QSaveFile file( fileName );
+  if( !file.open( QIODevice::WriteOnly ) ) {
+    qDebug() << "Can not write the catalog snapshot" << fileName;
+    return false;
+  }
+
+  QDataStream out( &file );
+  out.setVersion( QDataStream::Qt_5_6 );
+  out << SnapshotMagic << SnapshotVersion << key << qint32( m_flosList.size() );
+  for( FloskelTemplate *flos : m_flosList ) {
+    out << qint32( flos->getTemplID() ) << qint32( flos->unitId() ) << qint32( flos->chapterId().toInt() )
+        << qint32( flos->calcKind() ) << flos->getText() << flos->enterDate() << flos->modifyDate()
+        << qint64( flos->manualPrice().toLong() ) << flos->hasTimeslice() << flos->hasStoredPrice()
+        << qint64( flos->storedPrice().toLong() ) << qint32( flos->sortKey() )
+        << qint32( flos->useCounter() ) << flos->lastUsedDate();
+  }
+  return file.commit();
+}
+
+int TemplKatalog::loadTemplates()
 {
   Katalog::load();
   int cnt = 0;
@@ -96,19 +615,17 @@ int TemplKatalog::load()
   if (mChapters.isEmpty())
       getKatalogChapters(true);
 
-  QString chapIdList {"0"};
-  for( const CatalogChapter& chap : mChapters ) {
-      chapIdList.append(",");
-      chapIdList.append(chap.id().toString());
-  }
+  const QString chapIdList = chapterIdList();
 
   // qDebug () << "The chapterIdList: " << chapIdList;
   QSqlQuery q("SELECT unitID, TemplID, chapterID, Preisart, EPreis, modifyDatum, enterDatum, "
-              "Floskel, Gewinn, zeitbeitrag FROM Catalog WHERE chapterID IN( " + chapIdList + ") "
+              "Floskel, Gewinn, zeitbeitrag, calcPrice, sortKey FROM Catalog WHERE chapterID IN( " + chapIdList + ") "
               "ORDER BY chapterID, sortKey" );
   q.exec();
 
   m_flosList.clear();
+  mDependenciesLoaded = false;
+  mChapterIndexValid = false;
 
   while ( q.next() ) {
     cnt++;
@@ -116,15 +633,10 @@ int TemplKatalog::load()
     int templID = q.value(1).toInt();
     // qDebug () << "Loading template number " << templID << endl;
     int chapID = q.value(2).toInt();
-    // int sortID = cur.value( "sortKey" ).toInt();
     int calcKind = q.value(3).toInt();
     double g = q.value(4).toDouble();
 
     Geld preis(g);
-    /* Only for debugging: */
-    if( templID == 272 ) {
-      // qDebug () << "Geld ist " << preis.toString( *( &mLocale ) ) << " from g-value " << g << endl;
-    }
 
     QDateTime modDt = q.value(5).toDateTime();
     QDateTime enterDt = q.value(6).toDateTime();
@@ -136,19 +648,144 @@ int TemplKatalog::load()
                                                  einheit, chapID, calcKind );
     flos->setEnterDate( enterDt );
     flos->setModifyDate( modDt );
-    // flos->setSortKey( sortID );
-    flos->setBenefit( q.value(8).toDouble());
+    flos->setSortKey( q.value(11).toInt() );
+    // the benefit is kept in the calculation parts
     flos->setManualPrice( preis );
     bool tslice = q.value(9).toInt() > 0;
     flos->setHasTimeslice( tslice );
+    if( !q.value(10).isNull() ) {
+      flos->setStoredPrice( Geld(q.value(10).toDouble()) );
+    }
 
-    auto usage = usageCount(templID);
-    flos->setLastUsedDate(usage.second);
-    flos->setUseCounter(usage.first);
+    m_flosList.append(flos);
+  }
+  return cnt;
+}
 
-    loadCalcParts( flos );
+void TemplKatalog::loadUsageCounts( const QHash<int, FloskelTemplate*>& templates )
+{
+  QSqlQuery q;
+  q.prepare("SELECT itemId, usageCount, lastUsed FROM catItemUsage WHERE catId=:catId");
+  q.bindValue(":catId", id().toInt());
+  q.exec();
 
-    m_flosList.append(flos);
+  while( q.next() ) {
+    FloskelTemplate *flos = templates.value(q.value(0).toInt());
+    if( flos ) {
+      flos->setUseCounter(q.value(1).toInt());
+      flos->setLastUsedDate(q.value(2).toDateTime());
+      mUsage.insert(flos->getTemplID(), qMakePair(flos->useCounter(), flos->lastUsedDate()));
+    }
+  }
+}
+
+int TemplKatalog::loadAllTimeCalcParts( const QHash<int, FloskelTemplate*>& templates,
+                                        const QString& cond )
+{
+  int cnt = 0;
+
+  QSqlQuery q("SELECT t.TCalcID, t.TemplID, t.name, t.minutes, t.percent, t.stdHourSet, t.allowGlobal, t.timeUnit"
+              " FROM CalcTime t JOIN Catalog c ON c.TemplID = t.TemplID"
+              " WHERE " + cond + " ORDER BY t.TemplID, t.TCalcID");
+  q.exec();
+
+  // the hour rates are queried once per rate, not per part
+  QHash<int, StdSatz> rates;
+
+  while( q.next() ) {
+    int templid = q.value(1).toInt();
+    FloskelTemplate *flos = templates.value(templid);
+    if( !flos ) continue;
+
+    cnt++;
+    int tcalcid = q.value(0).toInt();
+    const QString name = q.value(2).toString();
+    int minutes = q.value(3).toInt();
+    int prozent = q.value(4).toInt();
+    int hourSet = q.value(5).toInt();
+    bool globAllowed = q.value(6).toInt() > 0;
+    int timeUnit = q.value(7).toInt();
+
+    auto rate = rates.find(hourSet);
+    if( rate == rates.end() ) {
+      rate = rates.insert(hourSet, StdSatzMan::self()->getStdSatz(hourSet));
+    }
+
+    TimeCalcPart::TimeUnit unit = TimeCalcPart::timeUnitFromInt(timeUnit);
+    TimeCalcPart *zcp = new TimeCalcPart( name, minutes, unit, prozent );
+    zcp->setGlobalStdSetAllowed( globAllowed );
+    zcp->setStundensatz( rate.value() );
+
+    zcp->setDbID( dbID(tcalcid));
+    zcp->setTemplID( dbID(templid));
+    zcp->setDirty( false );
+    flos->addCalcPart( zcp );
+  }
+  return cnt;
+}
+
+int TemplKatalog::loadAllMaterialCalcParts( const QHash<int, FloskelTemplate*>& templates,
+                                            const QString& cond )
+{
+  int cnt = 0;
+
+  // the catalog is looked up once for all parts
+  MatKatalog *matKatalog = MaterialCalcPart::materialCatalog();
+
+  QSqlQuery q("SELECT m.MCalcID, m.TemplID, m.materialID, m.percent, m.amount"
+              " FROM CalcMaterials m JOIN Catalog c ON c.TemplID = m.TemplID"
+              " WHERE " + cond + " ORDER BY m.TemplID, m.MCalcID");
+  q.exec();
+
+  while( q.next() ) {
+    int templid = q.value(1).toInt();
+    FloskelTemplate *flos = templates.value(templid);
+    if( !flos ) continue;
+
+    cnt++;
+    long mcalcID = q.value(0).toLongLong();
+    long   matID  = q.value(2).toLongLong();
+    int procent = q.value(3).toInt();
+    double amount = q.value(4).toDouble();
+
+    StockMaterial *mat = matKatalog ? matKatalog->materialFromId(matID) : nullptr;
+    MaterialCalcPart *mPart = new MaterialCalcPart( mcalcID, mat, procent, amount );
+    mPart->setDbID( dbID(mcalcID));
+    mPart->setTemplID( dbID(templid));
+    mPart->setDirty( false );
+    flos->addCalcPart( mPart );
+  }
+  return cnt;
+}
+
+int TemplKatalog::loadAllFixCalcParts( const QHash<int, FloskelTemplate*>& templates,
+                                       const QString& cond )
+{
+  int cnt = 0;
+
+  QSqlQuery q("SELECT f.name, f.amount, f.percent, f.FCalcID, f.TemplID, f.price"
+              " FROM CalcFixed f JOIN Catalog c ON c.TemplID = f.TemplID"
+              " WHERE " + cond + " ORDER BY f.TemplID, f.FCalcID");
+  q.exec();
+
+  while( q.next() ) {
+    int templid = q.value(4).toInt();
+    FloskelTemplate *flos = templates.value(templid);
+    if( !flos ) continue;
+
+    cnt++;
+    QString name  = q.value(0).toString();
+    double amount = q.value(1).toDouble();
+    int percent   = q.value(2).toInt();
+    int tcalcid = q.value(3).toInt();
+    Geld price(q.value(5).toDouble());
+
+    FixCalcPart *fcp = new FixCalcPart( name, price, percent );
+    fcp->setMenge( amount );
+    fcp->setDbID( dbID(tcalcid));
+    fcp->setTemplID( dbID(templid));
+    fcp->setDirty( false );
+    flos->addCalcPart( fcp );
   }
   return cnt;
 }
@@ -160,6 +797,8 @@ int TemplKatalog::addNewTemplate( FloskelTemplate *tmpl )
   if ( tmpl ) {
     m_flosList.append( tmpl );
     re = m_flosList.count();
+    mDependenciesLoaded = false;
+    mChapterIndexValid = false;
   }
   return re;
 }
@@ -182,6 +821,8 @@ void TemplKatalog::deleteTemplate( int id )
   if( cnt < m_flosList.size()) {
     m_flosList.removeAt( cnt );
   }
+  mDependenciesLoaded = false;
+  mChapterIndexValid = false;
 
   QStringList tables;
   tables << "Catalog" << "CalcFixed" << "CalcMaterials" << "CalcTime";
@@ -201,6 +842,9 @@ int TemplKatalog::loadCalcParts( FloskelTemplate *flos )
 {
   int cnt = 0;
 
+  // marks the parts as loaded, adding the parts does not load them again
+  flos->clearCalcParts();
+
   cnt = loadTimeCalcParts( flos );
   cnt += loadFixCalcParts( flos );
   cnt += loadMaterialCalcParts(flos);
@@ -307,32 +951,36 @@ int TemplKatalog::loadFixCalcParts( FloskelTemplate *flos )
 }
 
 
-FloskelTemplateList TemplKatalog::getFlosTemplates(int chapId)
+/*
+ * Sorts all templates into their chapters in one pass. Rebuilt if the
+ * list of templates changed or a template was moved to another chapter.
+ */
+void TemplKatalog::buildChapterIndex()
 {
-  FloskelTemplateList resultList;
+  mChapterTemplates.clear();
+  for( FloskelTemplate *tmpl : m_flosList ) {
+    mChapterTemplates[tmpl->chapterId().toInt()].append( tmpl );
+  }
+  mChapterIndexValid = true;
+}
 
+void TemplKatalog::invalidateChapterIndex()
+{
+  mChapterIndexValid = false;
+}
+
+FloskelTemplateList TemplKatalog::getFlosTemplates(int chapId)
+{
   if( m_flosList.count() == 0 )
   {
     // qDebug () << "Empty katalog list - loading!" << endl;
     load();
   }
 
-  FloskelTemplateListIterator it(m_flosList);
-  FloskelTemplate *tmpl;
-
-  while( it.hasNext() )
-  {
-    tmpl = it.next();
-
-    int haveChap = tmpl->chapterId().toInt();
-
-    // qDebug() << "Searching for chapter " << chapter << " with ID " << chap << " and have " << haveChap << endl;
-    if( haveChap == chapId )
-    {
-      resultList.append( tmpl );
-    }
+  if( !mChapterIndexValid ) {
+    buildChapterIndex();
   }
-  return resultList;
+  return mChapterTemplates.value( chapId );
 }
 
 
@@ -20,6 +20,9 @@
 
 #include <sys/types.h>
 
+#include <QHash>
+#include <QMultiHash>
+
 #include "floskeltemplate.h"
 #include "katalog.h"
 #include "dbids.h"
@@ -38,6 +41,7 @@ public:
 
     int load(const QString&);
     int load() override;
+    int loadPerTemplate();
     void reload( dbID ) override;
 
     /** No descriptions */
@@ -52,16 +56,82 @@ public:
 
     int addNewTemplate( FloskelTemplate *tmpl );
 
+    void invalidateChapterIndex() override;
+
+    /** loads the calculation parts of a single template */
+    static int loadCalcParts( FloskelTemplate* );
+
+    /**
+     * The templates with a calculated price that use the hour rate or
+     * the material in their calculation parts. Looked up in a reverse
+     * index, which is read from the database once.
+     */
+    QList<FloskelTemplate*> templatesUsingRate( dbID rateId );
+    QList<FloskelTemplate*> templatesUsingMaterial( dbID materialId );
+
+    /**
+     * The amount of templates whose price depends on the hour rate or
+     * the material, to be shown before changing it.
+     */
+    static int rateUsage( dbID rateId );
+    static int materialUsage( dbID materialId );
+
+    /**
+     * Recompute and store the prices of the templates that use the hour
+     * rates or the material, in one transaction. Returns the amount of
+     * affected templates, or -1 if nothing was changed because the
+     * transaction failed.
+     */
+    static int hourRateChanged( dbID rateId );
+    static int hourRatesChanged( const QList<dbID>& rateIds );
+    static int materialChanged( dbID materialId );
+
+    /**
+     * The templates and their usage counts can be read from a binary
+     * snapshot file instead of the database. The snapshot is only used
+     * if its key, a checksum over the catalog tables, is still the same.
+     * The chapters are always read from the database, the calculation
+     * parts are loaded on first use as usual.
+     */
+    QByteArray snapshotKey();
+    bool loadSnapshot( const QString& fileName );
+    bool writeSnapshot( const QString& fileName );
+
 public slots:
     void writeXMLFile() override;
     void deleteTemplate( int );
 private:
-    int loadCalcParts( FloskelTemplate* );
-    int loadTimeCalcParts( FloskelTemplate* );
-    int loadFixCalcParts( FloskelTemplate* );
-    int loadMaterialCalcParts( FloskelTemplate * );
+    QString chapterIdList() const;
+    int loadTemplates();
+    void loadUsageCounts( const QHash<int, FloskelTemplate*>& );
+    int loadAllTimeCalcParts( const QHash<int, FloskelTemplate*>&, const QString& );
+    int loadAllFixCalcParts( const QHash<int, FloskelTemplate*>&, const QString& );
+    int loadAllMaterialCalcParts( const QHash<int, FloskelTemplate*>&, const QString& );
+    void loadMissingCalcParts( const QList<FloskelTemplate*>& );
+    void storeCalcPrices( const QList<FloskelTemplate*>& );
+    bool writeCalcPrices( const QList<FloskelTemplate*>&, QList<QPair<FloskelTemplate*, Geld> > * );
+    static int changePrices( const QString& partSelect, const QHash<TemplKatalog*, QList<FloskelTemplate*> >& );
+    void loadDependencies();
+    QList<FloskelTemplate*> dependentTemplates( const QMultiHash<int, int>&, int ) const;
+    static QList<TemplKatalog*> loadedCatalogs();
+    static int dropStoredPrices( const QString& partSelect, const QList<TemplKatalog*>& loaded );
+
+    static int loadTimeCalcParts( FloskelTemplate* );
+    static int loadFixCalcParts( FloskelTemplate* );
+    static int loadMaterialCalcParts( FloskelTemplate * );
 
     FloskelTemplateList m_flosList;
+
+    // hour rate and material id to the ids of the templates using them
+    QMultiHash<int, int> mRateUsers;
+    QMultiHash<int, int> mMaterialUsers;
+    QHash<int, FloskelTemplate*> mTemplatesById;
+    bool mDependenciesLoaded;
+
+    // the templates per chapter id, in the order of m_flosList
+    void buildChapterIndex();
+    QHash<int, FloskelTemplateList> mChapterTemplates;
+    bool mChapterIndexValid;
 };
 
 #endif
@@ -20,6 +20,8 @@
 #include <QMenu>
 #include <QHeaderView>
 #include <QByteArray>
+#include <QHelpEvent>
+#include <QToolTip>
 
 #include <klocalizedstring.h>
 
@@ -47,6 +49,7 @@ TemplKatalogListView::TemplKatalogListView(QWidget *w)
     labels << i18n("Calc. Type");
 
     setHeaderLabels(labels);
+    setItemDelegateForColumn( 0, new TemplTextDelegate( this ) );
 
     QByteArray headerState = QByteArray::fromBase64( KraftSettings::self()->templateCatViewHeader().toLatin1() );
     header()->restoreState(headerState);
@@ -72,22 +75,16 @@ void TemplKatalogListView::addCatalogDisplay( const QString& katName )
 
     setupChapters();
 
-    const QList<CatalogChapter> chapters = catalog->getKatalogChapters();
-    foreach( CatalogChapter chap, chapters ) {
-        if( mChapterDict.contains( chap.id().toInt() ) ) {
-            int chapId = chap.id().toInt();
-            QTreeWidgetItem *katItem = mChapterDict[chapId];
-            FloskelTemplateList katList = catalog->getFlosTemplates(chapId);
-            FloskelTemplateListIterator flosIt( katList );
-
-            while( flosIt.hasNext() ) {
-                FloskelTemplate *tmpl = flosIt.next();
-
-                /* create a ew item as the child of katalog entry */
-                addFlosTemplate( katItem, tmpl );
-                if ( mShowCalcParts )
-                    addCalcParts( tmpl );
-            }
+    // the templates of a chapter are added when it is expanded
+    QHashIterator<int, QTreeWidgetItem*> it( mChapterDict );
+    while( it.hasNext() ) {
+        it.next();
+        if( catalog->getFlosTemplates( it.key() ).isEmpty() ) {
+            continue;
+        }
+        setChapterLazy( it.value() );
+        if( it.value()->isExpanded() ) {
+            populateChapter( it.value() );
         }
     }
     // ... and all what is zero is going to the top level
@@ -98,12 +95,28 @@ void TemplKatalogListView::addCatalogDisplay( const QString& katName )
             addCalcParts( tmpl );
     }
 }
+void TemplKatalogListView::addChapterItems( QTreeWidgetItem *chapterItem, int chapterId )
+{
+    TemplKatalog *catalog = static_cast<TemplKatalog*>( KatalogMan::self()->getKatalog( m_catalogName ) );
+    if( !catalog ) return;
+
+    const FloskelTemplateList templates = catalog->getFlosTemplates( chapterId );
+    for( FloskelTemplate *tmpl : templates ) {
+        /* create a new item as the child of katalog entry */
+        addFlosTemplate( chapterItem, tmpl );
+        if ( mShowCalcParts )
+            addCalcParts( tmpl );
+    }
+}
+
 /*
  * add a single template to the view with setting icon etc.
  */
 QTreeWidgetItem* TemplKatalogListView::addFlosTemplate( QTreeWidgetItem *parentItem, FloskelTemplate *tmpl )
 {
     if( ! parentItem ) parentItem = m_root;
+    // a new template must not be added a second time with the chapter
+    populateChapter( parentItem );
     QTreeWidgetItem *listItem = new QTreeWidgetItem( parentItem );
     slFreshupItem( listItem, tmpl);
     tmpl->setListViewItem( listItem );
@@ -133,12 +146,9 @@ void TemplKatalogListView::slFreshupItem( QTreeWidgetItem *item, FloskelTemplate
 
     Geld g     = tmpl->unitPrice();
     const QString ck = tmpl->calcKindString();
-    const QString t  = Portal::textWrap(tmpl->getText(), 72, 4);
 
-    item->setText( 0, t );
-    if( t.endsWith(QStringLiteral("..."))) {
-        item->setToolTip(0, Portal::textWrap(tmpl->getText(), 72, 22));
-    }
+    // wrapped by the TemplTextDelegate
+    item->setText( 0, tmpl->getText() );
     QString h;
     h = QString( "%1 / %2" ).arg( g.toLocaleString() )
             .arg( tmpl->unit().einheitSingular() );
@@ -266,10 +276,47 @@ void TemplKatalogListView::updateItemSequence(QTreeWidgetItem *item, int seqNo)
     FloskelTemplate *flos = static_cast<FloskelTemplate*>( itemData(item) );
     // qDebug () << "Updating item " << flos->getTemplID() << " to sort key " << sequenceCnt;
     if( _query && flos ) {
-        _query->bindValue( 0, seqNo );
-        _query->bindValue( 1, flos->getTemplID() );
-        _query->exec();
+        _seqKeys.append( seqNo );
+        _seqIds.append( flos->getTemplID() );
+    }
+}
+
+int TemplKatalogListView::itemSortKey(QTreeWidgetItem *item)
+{
+    FloskelTemplate *flos = static_cast<FloskelTemplate*>( itemData(item) );
+    return flos ? flos->sortKey() : 0;
+}
+
+void TemplKatalogListView::setItemSortKey(QTreeWidgetItem *item, int seqNo)
+{
+    FloskelTemplate *flos = static_cast<FloskelTemplate*>( itemData(item) );
+    if( flos ) {
+        flos->setSortKey( seqNo );
+    }
+}
+
+TemplTextDelegate::TemplTextDelegate( QObject *parent )
+    : QStyledItemDelegate( parent )
+{
+}
+
+void TemplTextDelegate::initStyleOption( QStyleOptionViewItem *option, const QModelIndex &index ) const
+{
+    QStyledItemDelegate::initStyleOption( option, index );
+    option->text = Portal::textWrap( option->text, 72, 4 );
+}
+
+bool TemplTextDelegate::helpEvent( QHelpEvent *event, QAbstractItemView *view,
+                                   const QStyleOptionViewItem &option, const QModelIndex &index )
+{
+    if( event && event->type() == QEvent::ToolTip && !index.data( Qt::ToolTipRole ).isValid() ) {
+        const QString text = index.data( Qt::DisplayRole ).toString();
+        if( Portal::textWrap( text, 72, 4 ).endsWith( QStringLiteral("...") ) ) {
+            QToolTip::showText( event->globalPos(), Portal::textWrap( text, 72, 22 ), view );
+            return true;
+        }
     }
+    return QStyledItemDelegate::helpEvent( event, view, option, index );
 }
 
 void TemplKatalogListView::saveState()
@@ -19,6 +19,7 @@
 #define TEMPLKATALOGLISTVIEW_H
 
 #include <QSqlQuery>
+#include <QStyledItemDelegate>
 
 #include <kataloglistview.h>
 
@@ -57,6 +58,9 @@ public:
 protected:
   virtual void startUpdateItemSequence();
   virtual void updateItemSequence(QTreeWidgetItem *item, int seqNo);
+  int itemSortKey(QTreeWidgetItem *item) override;
+  void setItemSortKey(QTreeWidgetItem *item, int seqNo) override;
+  void addChapterItems( QTreeWidgetItem*, int chapterId ) override;
 
 private:
   bool mShowCalcParts;
@@ -64,4 +68,22 @@ private:
 
 };
 
+/*
+ * Wraps the template text when the item is painted. The items keep the
+ * full text, which is shown as tooltip if the wrapped text is cut off.
+ */
+class TemplTextDelegate : public QStyledItemDelegate
+{
+  Q_OBJECT
+
+public:
+  TemplTextDelegate( QObject *parent = nullptr );
+
+  bool helpEvent( QHelpEvent *event, QAbstractItemView *view,
+                  const QStyleOptionViewItem &option, const QModelIndex &index ) override;
+
+protected:
+  void initStyleOption( QStyleOptionViewItem *option, const QModelIndex &index ) const override;
+};
+
 #endif
@@ -16,13 +16,114 @@
  ***************************************************************************/
 
 #include "texttemplate.h"
+#include "kraftsettings.h"
 #include "ctemplate/template.h"
+#include "ctemplate/template_cache.h"
 #include "klocalizedstring.h"
 
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QPointer>
 #include <QDebug>
 
 #include <string.h>
 
+namespace {
+
+/*
+ * The ctemplate cache of all text templates. Instead of checking all
+ * cached template files for changes with every template that is set up,
+ * the check happens when the file system watcher reported a change, or
+ * at latest after the configured reload interval.
+ */
+class TemplateCacheManager
+{
+public:
+    TemplateCacheManager()
+        : _changed(false)
+    {
+        _lastCheck.start();
+    }
+
+    ctemplate::TemplateCache *cache()
+    {
+        return &_cache;
+    }
+
+    bool loadTemplate(const QString& fileName)
+    {
+        reloadIfDue();
+        watch(fileName);
+        return _cache.LoadTemplate(fileName.toStdString(), ctemplate::DO_NOT_STRIP);
+    }
+
+private:
+    void reloadIfDue()
+    {
+        const qint64 interval = 1000 * qMax(0, KraftSettings::self()->templateReloadInterval());
+        if (_changed || _lastCheck.elapsed() >= interval) {
+            // marks changed templates to be reloaded on their next usage
+            _cache.ReloadAllIfChanged(ctemplate::TemplateCache::LAZY_RELOAD);
+            _changed = false;
+            _lastCheck.restart();
+        }
+    }
+
+    void watch(const QString& fileName)
+    {
+        if (_watcher.isNull() && QCoreApplication::instance()) {
+            _watcher = new QFileSystemWatcher(QCoreApplication::instance());
+            QObject::connect(_watcher.data(), &QFileSystemWatcher::fileChanged, [this](const QString& file) {
+                _changed = true;
+                // editors that replace the file remove it from the watcher
+                if (!_watcher->files().contains(file)) {
+                    _watcher->addPath(file);
+                }
+            });
+        }
+        if (_watcher && !_watcher->files().contains(fileName)) {
+            _watcher->addPath(fileName);
+        }
+    }
+
+    ctemplate::TemplateCache _cache;
+    QPointer<QFileSystemWatcher> _watcher;
+    QElapsedTimer _lastCheck;
+    bool _changed;
+};
+
+Q_GLOBAL_STATIC(TemplateCacheManager, mCacheManager)
+
+/*
+ * Keys and section names come from a small, fixed set. Their Latin1
+ * representation is kept instead of converting them for every value.
+ */
+const QByteArray& latin1Key(const QString& key)
+{
+    static QHash<QString, QByteArray> keys;
+
+    auto it = keys.constFind(key);
+    if (it == keys.constEnd()) {
+        it = keys.insert(key, key.toLatin1());
+    }
+    return it.value();
+}
+
+ctemplate::TemplateString templateKey(const QString& key)
+{
+    const QByteArray& k = latin1Key(key);
+    return ctemplate::TemplateString(k.constData(), k.size());
+}
+
+void setDictValue(TemplateDictionary *dict, const QString& key, const QString& val)
+{
+    const QByteArray v = val.toUtf8();
+    dict->SetValue(templateKey(key), ctemplate::TemplateString(v.constData(), v.size()));
+}
+
+}
 
 TextTemplate::TextTemplate()
     :TextTemplateInterface(),
@@ -43,7 +144,7 @@ bool TextTemplate::createSubDictionary( const QString& parent, const QString& na
   bool re = false;
 
   if ( mDictionaries.contains( parent ) ) {
-    ttd.mDict = mDictionaries[parent]->AddSectionDictionary( name.toLatin1().data() );
+    ttd.mDict = mDictionaries[parent]->AddSectionDictionary( templateKey(name) );
     ttd.mParent = parent;
     ttd.mName = name;
     mDictionaries[name] = ttd.mDict;
@@ -55,8 +156,8 @@ bool TextTemplate::createSubDictionary( const QString& parent, const QString& na
 void TextTemplate::createDictionary( const QString& dictName )
 {
   if ( mStandardDict ) {
-    mDictionaries[dictName] = mStandardDict->AddSectionDictionary( dictName.toLatin1().data() );
-    mStandardDict->ShowSection( dictName.toLatin1().data() );
+    mDictionaries[dictName] = mStandardDict->AddSectionDictionary( templateKey(dictName) );
+    mStandardDict->ShowSection( templateKey(dictName) );
   }
 }
 
@@ -68,27 +169,27 @@ void TextTemplate::setValue( const QString& dictName, const QString& key, const
     dict = mDictionaries[dictName];
   } else {
     if( mStandardDict ) {
-      dict = mStandardDict->AddSectionDictionary( dictName.toLatin1().data() );
+      dict = mStandardDict->AddSectionDictionary( templateKey(dictName) );
       mDictionaries[dictName] = dict;
-      mStandardDict->ShowSection( dictName.toLatin1().data() );
+      mStandardDict->ShowSection( templateKey(dictName) );
     }
   }
 
   if ( dict )
-    dict->SetValue( key.toLatin1().data(), val.toStdString() ); // std::string( val.toUtf8() ) );
+    setDictValue( dict, key, val );
 }
 
 void TextTemplate::setValue( const QString& key, const QString& val )
 {
   if ( mStandardDict ) {
-    mStandardDict->SetValue( key.toLatin1().data(), val.toStdString() );
+    setDictValue( mStandardDict, key, val );
   }
 }
 
 void TextTemplate::setValue( Dictionary ttd, const QString& key, const QString& val )
 {
   if ( ttd.mDict ) {
-    ( ttd.mDict )->SetValue( key.toLatin1().data(), val.toStdString() );
+    setDictValue( ttd.mDict, key, val );
   }
 }
 
@@ -97,13 +198,10 @@ void TextTemplate::setValue( Dictionary ttd, const QString& key, const QString&
 bool TextTemplate::initialize()
 {
 
-   Template *tmpl = Template::GetTemplate(fileName().toStdString(), ctemplate::DO_NOT_STRIP );
-
-  if ( !tmpl || tmpl->state() != ctemplate::TS_READY ) {
+  if ( !mCacheManager->loadTemplate( fileName() ) ) {
     setError( i18n( "Failed to open template source" ) );
     return false;
   }
-  tmpl->ReloadAllIfChanged();
 
   if (mStandardDict)
       delete mStandardDict;
@@ -117,7 +215,8 @@ QString TextTemplate::expand()
     std::string output;
 
     if ( mStandardDict) {
-        bool errorFree = ExpandTemplate( fileName().toStdString(), ctemplate::DO_NOT_STRIP ,mStandardDict, &output );
+        bool errorFree = mCacheManager->cache()->ExpandWithData( fileName().toStdString(), ctemplate::DO_NOT_STRIP,
+                                                                 mStandardDict, nullptr, &output );
 
         QString qout = QString::fromStdString(output);
         qout.remove(QChar(0));
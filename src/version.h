@@ -2,5 +2,5 @@
 
 #define KRAFT_CODENAME "Gunny"
 
-#define KRAFT_REQUIRED_SCHEMA_VERSION 24
+#define KRAFT_REQUIRED_SCHEMA_VERSION 25
 
@@ -0,0 +1,433 @@
+/***************************************************************************
+  xrechnungbatchexporter.cpp - export many archived invoices as XRechnung
+                             -------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by Klaas Freitag
+    email                : kraft@freisturz.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QSet>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QThread>
+#include <QTimer>
+#include <QDebug>
+
+#include <KLocalizedString>
+
+#include "xrechnungbatchexporter.h"
+#include "batchrenderer.h"
+#include "addressprovider.h"
+#include "documenttemplate.h"
+#include "defaultprovider.h"
+#include "doctype.h"
+
+namespace {
+
+// Only this document type has an XRechnung template, see ArchDocDigest::hasXRechnungExport
+const QString InvoiceDocType = QStringLiteral("Rechnung");
+
+/*
+ * Writes one expanded XRechnung to its target file and validates it
+ * with xmllint if schema files are given. Runs on the thread pool.
+ */
+class WriteJob : public QRunnable
+{
+public:
+    WriteJob(QObject *receiver, const QString& ident, const QString& fileName, const QByteArray& content,
+             const QString& xmllint, const QString& schemaFile, const QString& schematronFile)
+        : _receiver(receiver),
+          _ident(ident),
+          _fileName(fileName),
+          _content(content),
+          _xmllint(xmllint),
+          _schemaFile(schemaFile),
+          _schematronFile(schematronFile)
+    {
+    }
+
+    void run() override
+    {
+        QString error = write();
+        if (error.isEmpty() && !_schemaFile.isEmpty()) {
+            error = validate(QStringLiteral("--schema"), _schemaFile);
+        }
+        if (error.isEmpty() && !_schematronFile.isEmpty()) {
+            error = validate(QStringLiteral("--schematron"), _schematronFile);
+        }
+        QMetaObject::invokeMethod(_receiver, "slotWriteDone", Qt::QueuedConnection,
+                                  Q_ARG(QString, _ident), Q_ARG(QString, error));
+    }
+
+private:
+    QString write()
+    {
+        QSaveFile file(_fileName);
+        if (!file.open(QIODevice::WriteOnly)) {
+            return i18n("Can not open %1 for writing.", _fileName);
+        }
+        file.write(_content);
+        if (!file.commit()) {
+            return i18n("Can not write %1.", _fileName);
+        }
+        return QString();
+    }
+
+    QString validate(const QString& option, const QString& schema)
+    {
+        QProcess process;
+        process.setProcessChannelMode(QProcess::MergedChannels);
+        // --nonet: never fetch any referenced schema from the network
+        process.start(_xmllint, QStringList() << QStringLiteral("--noout") << QStringLiteral("--nonet")
+                      << option << schema << _fileName);
+        if (!process.waitForFinished(-1) || process.exitStatus() != QProcess::NormalExit) {
+            return i18n("xmllint could not be run.");
+        }
+        if (process.exitCode() != 0) {
+            const QString out = QString::fromLocal8Bit(process.readAll()).trimmed();
+            return i18n("Validation against %1 failed: %2", QFileInfo(schema).fileName(), out);
+        }
+        return QString();
+    }
+
+    QObject *_receiver;
+    QString _ident;
+    QString _fileName;
+    QByteArray _content;
+    QString _xmllint;
+    QString _schemaFile;
+    QString _schematronFile;
+};
+
+}
+
+XRechnungBatchExporter::XRechnungBatchExporter(QObject *parent)
+    : QObject(parent),
+      _dueDays(21),
+      _buyerRef(QStringLiteral("unknown")),
+      _addressProvider(nullptr),
+      _lookupTimeout(30),
+      _expanding(false),
+      _writing(0),
+      _total(0),
+      _succeeded(0),
+      _finished(false)
+{
+    _writers.setMaxThreadCount(QThread::idealThreadCount());
+
+    // headless, the address backend might never answer
+    _lookupTimer.setSingleShot(true);
+    connect(&_lookupTimer, &QTimer::timeout, this, &XRechnungBatchExporter::slotLookupTimeout);
+}
+
+XRechnungBatchExporter::~XRechnungBatchExporter()
+{
+    // the jobs post their results to this object
+    _writers.waitForDone();
+}
+
+void XRechnungBatchExporter::setDateRange(const QDate& from, const QDate& to)
+{
+    _from = from;
+    _to = to;
+}
+
+void XRechnungBatchExporter::setIdents(const QStringList& idents)
+{
+    _idents = idents;
+    _idents.removeDuplicates();
+}
+
+void XRechnungBatchExporter::setOutputDir(const QString& dir)
+{
+    _outputDir = dir;
+}
+
+void XRechnungBatchExporter::setDueDays(int days)
+{
+    _dueDays = days;
+}
+
+void XRechnungBatchExporter::setBuyerRef(const QString& ref)
+{
+    _buyerRef = ref;
+}
+
+void XRechnungBatchExporter::setSchemaFile(const QString& xsd)
+{
+    _schemaFile = xsd;
+}
+
+void XRechnungBatchExporter::setSchematronFile(const QString& sch)
+{
+    _schematronFile = sch;
+}
+
+void XRechnungBatchExporter::setMaxJobs(int jobs)
+{
+    _writers.setMaxThreadCount(qMax(1, jobs));
+}
+
+void XRechnungBatchExporter::setLookupTimeout(int secs)
+{
+    _lookupTimeout = qMax(0, secs);
+}
+
+void XRechnungBatchExporter::start()
+{
+    if (_idents.isEmpty() && (!_from.isValid() || !_to.isValid() || _from > _to)) {
+        _setupError = i18n("Neither a valid date range nor document idents are given.");
+        finish(SetupFailed);
+        return;
+    }
+
+    if (_outputDir.isEmpty()) {
+        _outputDir = QDir::currentPath();
+    }
+    QDir dir;
+    if (!dir.mkpath(_outputDir)) {
+        _setupError = i18n("The output directory %1 can not be created.", _outputDir);
+        finish(SetupFailed);
+        return;
+    }
+
+    for (const QString& f : { _schemaFile, _schematronFile }) {
+        if (!f.isEmpty() && !QFileInfo(f).isReadable()) {
+            _setupError = i18n("The validation file %1 can not be read.", f);
+            finish(SetupFailed);
+            return;
+        }
+    }
+    if ((!_schemaFile.isEmpty() || !_schematronFile.isEmpty())
+            && DefaultProvider::self()->locateBinary(QStringLiteral("xmllint")).isEmpty()) {
+        _setupError = i18n("The validation requires xmllint, which can not be found.");
+        finish(SetupFailed);
+        return;
+    }
+
+    if (!BatchRenderer::connectDatabase(&_setupError)) {
+        finish(SetupFailed);
+        return;
+    }
+
+    // the doc type and the template are the same for all documents
+    DocType dt(InvoiceDocType);
+    const QString tmplFile = dt.xRechnungTemplate();
+    if (tmplFile.isEmpty() || !QFileInfo(tmplFile).isReadable()) {
+        _setupError = i18n("The XRechnung template file is not set or can not be read.");
+        finish(SetupFailed);
+        return;
+    }
+    _template.reset(new GrantleeDocumentTemplate(tmplFile));
+
+    _addressProvider = new AddressProvider(this);
+    connect(_addressProvider, &AddressProvider::lookupResult,
+            this, &XRechnungBatchExporter::slotAddresseeFound);
+
+    _queue = archivedDocuments();
+    _total = _queue.size();
+
+    // a requested ident that is not found must not pass unnoticed
+    QSet<QString> found;
+    for (const ArchDocDigest& digest : _queue) {
+        found.insert(digest.archDocIdent());
+    }
+    for (const QString& ident : _idents) {
+        if (!found.contains(ident)) {
+            _failures[ident] = i18n("There is no archived invoice with this ident.");
+            _total++;
+        }
+    }
+
+    qDebug() << "Exporting" << _total << "invoices as XRechnung to" << _outputDir;
+    exportNext();
+}
+
+/*
+ * Returns the latest archived version of every invoice that is either
+ * in the list of idents or dated within the range.
+ */
+QList<ArchDocDigest> XRechnungBatchExporter::archivedDocuments() const
+{
+    QSqlQuery q;
+    if (_idents.isEmpty()) {
+        q.prepare("SELECT archDocID, ident, docType, printDate, state FROM archdoc WHERE "
+                  "docType = ? AND date BETWEEN ? AND ? ORDER BY ident, printDate");
+        q.addBindValue(InvoiceDocType);
+        q.addBindValue(_from.toString("yyyy-MM-dd"));
+        q.addBindValue(_to.toString("yyyy-MM-dd"));
+    } else {
+        QStringList marks;
+        for (int i = 0; i < _idents.size(); i++) {
+            marks.append(QStringLiteral("?"));
+        }
+        q.prepare(QString("SELECT archDocID, ident, docType, printDate, state FROM archdoc WHERE "
+                          "docType = ? AND ident IN (%1) ORDER BY ident, printDate").arg(marks.join(", ")));
+        q.addBindValue(InvoiceDocType);
+        for (const QString& ident : _idents) {
+            q.addBindValue(ident);
+        }
+    }
+    if (!q.exec()) {
+        qDebug() << "Failed to read the archived invoices:" << q.lastError().text();
+    }
+
+    QMap<QString, ArchDocDigest> latest;
+    while (q.next()) {
+        const QString ident = q.value(1).toString();
+        latest[ident] = ArchDocDigest(q.value(3).toDateTime(), q.value(4).toInt(),
+                                      ident, q.value(2).toString(), dbID(q.value(0).toInt()));
+    }
+    return latest.values();
+}
+
+void XRechnungBatchExporter::exportNext()
+{
+    if (_queue.isEmpty()) {
+        _currentIdent.clear();
+        checkFinished();
+        return;
+    }
+
+    const ArchDocDigest digest = _queue.takeFirst();
+    _currentIdent = digest.archDocIdent();
+    _archDoc.loadFromDb(digest.archDocId());
+    _archDoc.setDueDate(_archDoc.date().addDays(_dueDays));
+    _archDoc.setBuyerRef(_buyerRef);
+
+    KContacts::Addressee contact;
+    const QString clientUid = _archDoc.clientUid();
+    _expanding = true;
+    if (!clientUid.isEmpty() && _lookupTimeout > 0) {
+        const AddressProvider::LookupState state = _addressProvider->lookupAddressee(clientUid);
+        if (!_expanding) {
+            // the result was delivered right away through slotAddresseeFound
+            return;
+        }
+        switch (state) {
+        case AddressProvider::LookupFromCache:
+            contact = _addressProvider->getAddresseeFromCache(clientUid);
+            break;
+        case AddressProvider::LookupNotFound:
+        case AddressProvider::ItemError:
+        case AddressProvider::BackendError:
+            break;
+        case AddressProvider::LookupOngoing:
+        case AddressProvider::LookupStarted:
+            // continues in slotAddresseeFound or slotLookupTimeout
+            _lookupTimer.start(_lookupTimeout * 1000);
+            return;
+        }
+    }
+    expandCurrent(contact);
+}
+
+void XRechnungBatchExporter::slotAddresseeFound(const QString& uid, const KContacts::Addressee& contact)
+{
+    if (!_expanding || uid != _archDoc.clientUid()) {
+        return;
+    }
+    expandCurrent(contact);
+}
+
+void XRechnungBatchExporter::slotLookupTimeout()
+{
+    if (!_expanding) {
+        return;
+    }
+    qDebug() << "Address lookup timed out for" << _currentIdent;
+    _warnings[_currentIdent] = i18n("The address lookup did not answer within %1 seconds, "
+                                    "exported without the customer address.", _lookupTimeout);
+    expandCurrent(KContacts::Addressee());
+}
+
+void XRechnungBatchExporter::expandCurrent(const KContacts::Addressee& contact)
+{
+    _expanding = false;
+    _lookupTimer.stop();
+
+    // the own identity is not used by the XRechnung template, same as for
+    // the interactive export
+    const QString expanded = _template->expand(&_archDoc, KContacts::Addressee(), contact);
+
+    if (expanded.isEmpty()) {
+        _failures[_currentIdent] = i18n("The template expansion failed: %1", _template->error());
+    } else {
+        const QString fileName = QDir(_outputDir).filePath(QString("xrechnung_%1.xml").arg(_currentIdent));
+        _writing++;
+        _writers.start(new WriteJob(this, _currentIdent, fileName, expanded.toUtf8(),
+                                    DefaultProvider::self()->locateBinary(QStringLiteral("xmllint")),
+                                    _schemaFile, _schematronFile));
+    }
+
+    // do not recurse, the lookup result can arrive from within exportNext
+    QTimer::singleShot(0, this, &XRechnungBatchExporter::exportNext);
+}
+
+void XRechnungBatchExporter::slotWriteDone(const QString& ident, const QString& error)
+{
+    _writing--;
+    if (error.isEmpty()) {
+        _succeeded++;
+    } else {
+        _failures[ident] = error;
+    }
+    checkFinished();
+}
+
+void XRechnungBatchExporter::checkFinished()
+{
+    if (_queue.isEmpty() && _currentIdent.isEmpty() && _writing == 0) {
+        finish(_failures.isEmpty() ? Success : DocumentsFailed);
+    }
+}
+
+void XRechnungBatchExporter::finish(int exitCode)
+{
+    if (_finished) {
+        return;
+    }
+    _finished = true;
+    emit finished(exitCode);
+}
+
+QString XRechnungBatchExporter::summary() const
+{
+    if (!_setupError.isEmpty()) {
+        return i18n("XRechnung export failed: %1", _setupError);
+    }
+
+    QString re = i18n("Exported %1 of %2 invoices as XRechnung to %3.", _succeeded, _total, _outputDir);
+    if (!_failures.isEmpty()) {
+        re += QLatin1Char('\n') + i18n("%1 invoices failed:", _failures.size());
+        QMapIterator<QString, QString> it(_failures);
+        while (it.hasNext()) {
+            it.next();
+            re += QString("\n  %1: %2").arg(it.key(), it.value());
+        }
+    }
+    if (!_warnings.isEmpty()) {
+        re += QLatin1Char('\n') + i18n("%1 invoices have warnings:", _warnings.size());
+        QMapIterator<QString, QString> it(_warnings);
+        while (it.hasNext()) {
+            it.next();
+            re += QString("\n  %1: %2").arg(it.key(), it.value());
+        }
+    }
+    return re;
+}
@@ -0,0 +1,131 @@
+/***************************************************************************
+   xrechnungbatchexporter.h - export many archived invoices as XRechnung
+                             -------------------
+    begin                : October 2026
+    copyright            : (C) 2026 by Klaas Freitag
+    email                : kraft@freisturz.de
+ ***************************************************************************/
+
+/***************************************************************************
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ ***************************************************************************/
+
+#ifndef XRECHNUNGBATCHEXPORTER_H
+#define XRECHNUNGBATCHEXPORTER_H
+
+#include <QObject>
+#include <QDate>
+#include <QList>
+#include <QMap>
+#include <QScopedPointer>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <kcontacts/addressee.h>
+
+#include "archdoc.h"
+
+class AddressProvider;
+class DocumentTemplate;
+
+/**
+ * Exports the archived invoices of a date range, or a list of document
+ * idents, as XRechnung files into a directory.
+ *
+ * The XRechnung template of the invoice document type is looked up once
+ * and expanded for one document after the other on the main thread, as
+ * the database and the address lookup are not shared. Writing the files
+ * and the optional validation against local XSD and Schematron files
+ * with xmllint run in parallel on a thread pool.
+ *
+ * Used by the --xrechnung command line mode of kraft.
+ */
+class XRechnungBatchExporter : public QObject
+{
+    Q_OBJECT
+public:
+    enum ExitCode { Success = 0, DocumentsFailed = 1, SetupFailed = 2 };
+
+    explicit XRechnungBatchExporter(QObject *parent = nullptr);
+    ~XRechnungBatchExporter() override;
+
+    void setDateRange(const QDate& from, const QDate& to);
+    void setIdents(const QStringList& idents);
+    void setOutputDir(const QString& dir);
+
+    // the due date of each invoice is its date plus the given days
+    void setDueDays(int days);
+    void setBuyerRef(const QString& ref);
+
+    // validates the written files if the files are set. No network access
+    // is done, all referenced schema files must be local.
+    void setSchemaFile(const QString& xsd);
+    void setSchematronFile(const QString& sch);
+
+    // amount of files written and validated in parallel. Defaults to the
+    // amount of cores.
+    void setMaxJobs(int jobs);
+
+    // seconds to wait for the address of a customer. If the lookup does
+    // not answer in time, the invoice is exported without the address and
+    // a warning. 0 skips the lookup. Defaults to 30 seconds.
+    void setLookupTimeout(int secs);
+
+    QString summary() const;
+
+signals:
+    void finished(int exitCode);
+
+public slots:
+    void start();
+
+private slots:
+    void slotAddresseeFound(const QString& uid, const KContacts::Addressee& contact);
+    void slotWriteDone(const QString& ident, const QString& error);
+    void slotLookupTimeout();
+
+private:
+    QList<ArchDocDigest> archivedDocuments() const;
+
+    void exportNext();
+    void expandCurrent(const KContacts::Addressee& contact);
+    void checkFinished();
+    void finish(int exitCode);
+
+    QDate _from;
+    QDate _to;
+    QStringList _idents;
+    QString _outputDir;
+    int _dueDays;
+    QString _buyerRef;
+    QString _schemaFile;
+    QString _schematronFile;
+
+    QScopedPointer<DocumentTemplate> _template;
+    AddressProvider *_addressProvider;
+    QThreadPool _writers;
+    QTimer _lookupTimer;
+    int _lookupTimeout;
+
+    QList<ArchDocDigest> _queue;
+    ArchDoc _archDoc;
+    QString _currentIdent;
+    bool _expanding;
+    int _writing;
+
+    int _total;
+    int _succeeded;
+    QMap<QString, QString> _failures;
+    QMap<QString, QString> _warnings;
+    QString _setupError;
+    bool _finished;
+};
+
+#endif // XRECHNUNGBATCHEXPORTER_H
@@ -0,0 +1,137 @@
+#include <QTest>
+#include <QObject>
+
+#include "docposition.h"
+#include "archdocposition.h"
+#include "geld.h"
+
+namespace {
+
+DocPosition *newPosition(double price, double amount, DocPositionBase::TaxType tt)
+{
+    DocPosition *dp = new DocPosition;
+    dp->setUnitPrice(Geld(price));
+    dp->setAmount(amount);
+    dp->setTaxType(tt);
+    return dp;
+}
+
+}
+
+class T_DocTotals : public QObject {
+    Q_OBJECT
+private slots:
+    void init()
+    {
+        _list = DocPositionList();
+        _list.append(newPosition(10.0, 2.0, DocPositionBase::TaxFull));
+        _list.append(newPosition(5.0, 1.0, DocPositionBase::TaxReduced));
+        _list.append(newPosition(3.0, 1.0, DocPositionBase::TaxNone));
+    }
+
+    void cleanup()
+    {
+        qDeleteAll(_list);
+        _list.clear();
+    }
+
+    void sums()
+    {
+        const DocTotals& t = _list.totals();
+        QCOMPARE(t.netto().toLong(), 2800L);
+        QCOMPARE(t.fullTaxBase().toLong(), 2000L);
+        QCOMPARE(t.reducedTaxBase().toLong(), 500L);
+        QCOMPARE(t.fullTax(19.0).toLong(), 380L);
+        QCOMPARE(t.reducedTax(7.0).toLong(), 35L);
+        QCOMPARE(t.taxSum(19.0, 7.0).toLong(), 415L);
+        QCOMPARE(t.brutto(19.0, 7.0).toLong(), 3215L);
+        QCOMPARE(t.count(), 3);
+        QCOMPARE(t.count(DocPositionBase::TaxNone), 1);
+
+        // the old per sum functions give the same results
+        QCOMPARE(_list.nettoPrice().toLong(), 2800L);
+        QCOMPARE(_list.bruttoPrice(19.0, 7.0).toLong(), 3215L);
+        QCOMPARE(_list.fullTaxSum(19.0).toLong(), 380L);
+        QCOMPARE(_list.reducedTaxSum(7.0).toLong(), 35L);
+    }
+
+    void kindIsNotCounted()
+    {
+        DocPosition *dp = static_cast<DocPosition*>(_list.at(1));
+        Attribute a(DocPosition::Kind);
+        a.setValue(QVariant(QStringLiteral("Alternative")));
+        dp->setAttribute(a);
+
+        QVERIFY(dp->hasKind());
+        QCOMPARE(dp->overallPrice().toLong(), 0L);
+        QCOMPARE(_list.totals().netto().toLong(), 2300L);
+        QCOMPARE(_list.totals().reducedTax(7.0).toLong(), 0L);
+    }
+
+    void invalidatedOnChange()
+    {
+        QCOMPARE(_list.totals().netto().toLong(), 2800L);
+
+        static_cast<DocPosition*>(_list.at(0))->setAmount(3.0);
+        QCOMPARE(_list.totals().netto().toLong(), 3800L);
+
+        _list.append(newPosition(1.0, 1.0, DocPositionBase::TaxFull));
+        QCOMPARE(_list.totals().netto().toLong(), 3900L);
+
+        delete _list.takeLast();
+        QCOMPARE(_list.totals().netto().toLong(), 3800L);
+
+        // a copy of the list shares the cached totals
+        const DocPositionList copy = _list;
+        QCOMPARE(copy.totals().fullTaxBase().toLong(), 3000L);
+    }
+
+    void otherListsStayValid()
+    {
+        DocPositionList other;
+        other.append(newPosition(2.0, 1.0, DocPositionBase::TaxFull));
+        const quint64 rev = other.at(0)->revision();
+
+        const quint64 listRev = _list.at(0)->revision();
+        QCOMPARE(_list.totals().netto().toLong(), 2800L);
+        QCOMPARE(other.totals().netto().toLong(), 200L);
+
+        static_cast<DocPosition*>(other.at(0))->setAmount(2.0);
+        QVERIFY(other.at(0)->revision() != rev);
+        // the positions of the list are not touched
+        QCOMPARE(_list.at(0)->revision(), listRev);
+        QCOMPARE(_list.totals().netto().toLong(), 2800L);
+        QCOMPARE(other.totals().netto().toLong(), 400L);
+        qDeleteAll(other);
+    }
+
+    void archivedAppendedAfterTaxes()
+    {
+        ArchDocPositionList list;
+        list.setTaxes(19.0, 7.0);
+        QCOMPARE(list.totals().count(), 0);
+
+        list.append(ArchDocPosition());
+        list.append(ArchDocPosition());
+        QCOMPARE(list.totals().count(), 2);
+
+        const ArchDocPositionList copy = list;
+        QCOMPARE(copy.totals().count(), 2);
+        list.removeLast();
+        QCOMPARE(list.totals().count(), 1);
+        QCOMPARE(copy.totals().count(), 2);
+    }
+
+    void noTaxOnNegativeBase()
+    {
+        static_cast<DocPosition*>(_list.at(0))->setUnitPrice(Geld(-10.0));
+        QCOMPARE(_list.totals().fullTax(19.0).toLong(), 0L);
+        QCOMPARE(_list.totals().netto().toLong(), -1200L);
+    }
+
+private:
+    DocPositionList _list;
+};
+
+QTEST_MAIN(T_DocTotals)
+#include "t_doctotals.moc"
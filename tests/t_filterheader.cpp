@@ -0,0 +1,138 @@
+#include <QTest>
+#include <QObject>
+#include <QTreeWidget>
+
+#include "filterheader.h"
+
+namespace {
+
+const QStringList Words = { "Mauerwerk", "Fliesen", "verlegen", "Estrich", "Putz", "Anstrich",
+                            "Dispersionsfarbe", "Gipskarton", "abbrechen", "entsorgen", "Graben",
+                            "Fundament", "Schalung", "Bewehrung", "Beton", "liefern" };
+
+// a catalog like tree: chapters with templates of two columns
+void fillTree(QTreeWidget *tree, int chapters, int templatesPerChapter)
+{
+    tree->setColumnCount(2);
+    QTreeWidgetItem *root = new QTreeWidgetItem(tree, QStringList() << "Catalog");
+    int n = 0;
+    for (int c = 0; c < chapters; c++) {
+        QTreeWidgetItem *chapter = new QTreeWidgetItem(root, QStringList() << QString("Chapter %1").arg(c));
+        for (int t = 0; t < templatesPerChapter; t++, n++) {
+            const QString text = QString("%1 %2 und %3, Pos. %4")
+                    .arg(Words.at(n % Words.size()), Words.at((n / 7) % Words.size()),
+                         Words.at((n / 3) % Words.size())).arg(n);
+            new QTreeWidgetItem(chapter, QStringList() << text << QString("%1 EUR").arg(n % 97));
+        }
+    }
+}
+
+// the items that should be visible for the filter
+int expectedVisible(QTreeWidget *tree, const QString& filter)
+{
+    int cnt = 0;
+    QTreeWidgetItemIterator it(tree);
+    while (*it) {
+        QTreeWidgetItem *item = *it;
+        if (item->parent() && item->childCount() == 0) {
+            if (item->text(0).contains(filter, Qt::CaseInsensitive)
+                    || item->text(1).contains(filter, Qt::CaseInsensitive)) {
+                cnt++;
+            }
+        }
+        ++it;
+    }
+    return cnt;
+}
+
+int visibleTemplates(QTreeWidget *tree)
+{
+    int cnt = 0;
+    QTreeWidgetItemIterator it(tree);
+    while (*it) {
+        QTreeWidgetItem *item = *it;
+        if (item->parent() && item->childCount() == 0 && !item->isHidden()) {
+            cnt++;
+        }
+        ++it;
+    }
+    return cnt;
+}
+
+}
+
+class T_FilterHeader : public QObject {
+    Q_OBJECT
+private slots:
+    void filter()
+    {
+        QTreeWidget tree;
+        fillTree(&tree, 10, 20);
+        FilterHeader header(nullptr, &tree);
+
+        for (const QString& f : { "b", "be", "bet", "beto", "beton", "eton l", "BETON", "gips",
+                                  "eur", "13 eur", "xyz", "" }) {
+            header.setFilterText(f);
+            QCOMPARE(visibleTemplates(&tree), expectedVisible(&tree, f));
+        }
+        // all open again with the empty filter
+        QCOMPARE(visibleTemplates(&tree), 200);
+        QVERIFY(!tree.topLevelItem(0)->child(3)->isExpanded());
+    }
+
+    void parentsShown()
+    {
+        QTreeWidget tree;
+        fillTree(&tree, 3, 4);
+        FilterHeader header(nullptr, &tree);
+
+        header.setFilterText("Pos. 9");
+        QTreeWidgetItem *chapter = tree.topLevelItem(0)->child(2);
+        QVERIFY(!chapter->isHidden());
+        QVERIFY(chapter->isExpanded());
+        QVERIFY(!chapter->child(1)->isHidden());
+        QVERIFY(tree.topLevelItem(0)->child(0)->isHidden());
+
+        // the chapter names are matched as well
+        header.setFilterText("Chapter 1");
+        QVERIFY(!tree.topLevelItem(0)->child(1)->isHidden());
+    }
+
+    void treeChanged()
+    {
+        QTreeWidget tree;
+        fillTree(&tree, 3, 4);
+        FilterHeader header(nullptr, &tree);
+
+        header.setFilterText("Rigips");
+        QCOMPARE(visibleTemplates(&tree), 0);
+
+        QTreeWidgetItem *item = tree.topLevelItem(0)->child(1)->child(0);
+        item->setText(0, "Rigipswand stellen");
+        new QTreeWidgetItem(tree.topLevelItem(0)->child(2), QStringList() << "Rigips spachteln");
+
+        header.setFilterText("Rigips ");
+        QCOMPARE(visibleTemplates(&tree), 1);
+        header.setFilterText("Rigips");
+        QCOMPARE(visibleTemplates(&tree), 2);
+    }
+
+    // typing a word into the filter of a large catalog
+    void benchmark()
+    {
+        QTreeWidget tree;
+        fillTree(&tree, 200, 100);
+        FilterHeader header(nullptr, &tree);
+
+        QBENCHMARK {
+            for (const QString& f : { "d", "di", "dis", "disp", "dispe", "disper", "dispers", "", "p", "po", "pos", "pos.", "pos. 1", "" }) {
+                header.setFilterText(f);
+            }
+        }
+        header.setFilterText("Dispersionsfarbe");
+        QCOMPARE(visibleTemplates(&tree), expectedVisible(&tree, "Dispersionsfarbe"));
+    }
+};
+
+QTEST_MAIN(T_FilterHeader)
+#include "t_filterheader.moc"
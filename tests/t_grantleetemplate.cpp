@@ -0,0 +1,159 @@
+#include <QTest>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QDateTime>
+#include <QFile>
+
+#include <grantlee/engine.h>
+#include <grantlee/context.h>
+#include <grantlee/templateloader.h>
+
+#include "grantleetemplate.h"
+
+namespace {
+
+QVariantHash sampleMe()
+{
+    QVariantHash me;
+    me.insert("ORGANISATION", "Kraft Software");
+    me.insert("STREET", "Musterstr. 1");
+    me.insert("POSTCODE", "12345");
+    me.insert("LOCALITY", "Berlin");
+    me.insert("EMAIL", "kraft@example.com");
+    return me;
+}
+
+QVariantHash sampleDoc()
+{
+    QVariantHash doc;
+    doc.insert("ident", "20210815-1");
+    doc.insert("docType", "Rechnung");
+    doc.insert("address", "Max Muster\nHauptstr. 5\n54321 Musterstadt");
+    doc.insert("nettoSumStr", "1.000,00 €");
+    return doc;
+}
+
+void fillTemplate(GrantleeFileTemplate& tmpl)
+{
+    tmpl.addToMapping("me", sampleMe());
+    tmpl.addToMapping("doc", sampleDoc());
+}
+
+// renders the way GrantleeFileTemplate did without the cache
+QString renderUncached(const QString& file)
+{
+    QFileInfo fi(file);
+    Grantlee::Engine engine;
+    auto loader = QSharedPointer<Grantlee::FileSystemTemplateLoader>::create();
+    loader->setTemplateDirs( {fi.absolutePath()} );
+    engine.addTemplateLoader(loader);
+
+    auto t = engine.loadByName(fi.fileName());
+    QVariantHash mapping;
+    mapping.insert("me", sampleMe());
+    mapping.insert("doc", sampleDoc());
+    Grantlee::Context c(mapping);
+    return t->render(&c);
+}
+
+void writeFile(const QString& name, const QByteArray& content)
+{
+    QFile f(name);
+    f.open(QIODevice::WriteOnly);
+    f.write(content);
+    f.close();
+}
+
+}
+
+class T_GrantleeTemplate : public QObject {
+    Q_OBJECT
+private slots:
+    void initTestCase()
+    {
+        _invoice = QFINDTESTDATA("../reports/invoice.gtmpl");
+        QVERIFY(!_invoice.isEmpty());
+    }
+
+    void sameResultAsUncached()
+    {
+        GrantleeFileTemplate tmpl(_invoice);
+        fillTemplate(tmpl);
+
+        bool ok;
+        const QString first = tmpl.render(ok);
+        QVERIFY(ok);
+        // the second render comes from the cache
+        const QString second = tmpl.render(ok);
+        QVERIFY(ok);
+
+        const QString reference = renderUncached(_invoice);
+        QCOMPARE(first, reference);
+        QCOMPARE(second, reference);
+    }
+
+    void reloadOnChange()
+    {
+        QTemporaryDir dir;
+        const QString file = dir.filePath("t.gtmpl");
+        writeFile(file, "Hello {{ doc.ident }}");
+
+        GrantleeFileTemplate tmpl(file);
+        fillTemplate(tmpl);
+        bool ok;
+        QCOMPARE(tmpl.render(ok), QStringLiteral("Hello 20210815-1"));
+
+        writeFile(file, "Bye {{ doc.ident }}");
+        // make sure the modification time differs
+        QFile f(file);
+        QVERIFY(f.open(QIODevice::ReadWrite));
+        QVERIFY(f.setFileTime(QDateTime::currentDateTime().addSecs(10), QFileDevice::FileModificationTime));
+        f.close();
+
+        QCOMPARE(tmpl.render(ok), QStringLiteral("Bye 20210815-1"));
+    }
+
+    void reloadOnIncludeChange()
+    {
+        QTemporaryDir dir;
+        const QString file = dir.filePath("t.gtmpl");
+        const QString footer = dir.filePath("footer.gtmpl");
+        writeFile(file, "Hello {{ doc.ident }} {% include \"footer.gtmpl\" %}");
+        writeFile(footer, "Regards");
+
+        GrantleeFileTemplate tmpl(file);
+        fillTemplate(tmpl);
+        bool ok;
+        QCOMPARE(tmpl.render(ok), QStringLiteral("Hello 20210815-1 Regards"));
+
+        // only the included file changes
+        writeFile(footer, "Cheers");
+        QFile f(footer);
+        QVERIFY(f.open(QIODevice::ReadWrite));
+        QVERIFY(f.setFileTime(QDateTime::currentDateTime().addSecs(10), QFileDevice::FileModificationTime));
+        f.close();
+
+        QCOMPARE(tmpl.render(ok), QStringLiteral("Hello 20210815-1 Cheers"));
+    }
+
+    void benchmarkInvoice()
+    {
+        GrantleeFileTemplate::clearCache();
+        GrantleeFileTemplate tmpl(_invoice);
+        fillTemplate(tmpl);
+
+        bool ok = true;
+        QBENCHMARK_ONCE {
+            for (int i = 0; i < 1000; i++) {
+                tmpl.render(ok);
+            }
+        }
+        QVERIFY(ok);
+    }
+
+private:
+    QString _invoice;
+};
+
+QTEST_MAIN(T_GrantleeTemplate)
+#include "t_grantleetemplate.moc"
@@ -0,0 +1,88 @@
+#include <QTest>
+#include <QObject>
+#include <QVector>
+
+#include "kataloglistview.h"
+
+namespace {
+
+bool increasing(const QVector<int>& keys)
+{
+    for (int i = 1; i < keys.size(); i++) {
+        if (keys.at(i - 1) >= keys.at(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int changed(const QVector<int>& a, const QVector<int>& b)
+{
+    int cnt = 0;
+    for (int i = 0; i < a.size(); i++) {
+        if (a.at(i) != b.at(i)) {
+            cnt++;
+        }
+    }
+    return cnt;
+}
+
+}
+
+class T_KatalogListView : public QObject {
+    Q_OBJECT
+private slots:
+    void keysInOrder()
+    {
+        QVERIFY(KatalogListView::gapSortKeys(QVector<int>()).isEmpty());
+
+        const QVector<int> keys { 1024, 2048, 3072 };
+        QCOMPARE(KatalogListView::gapSortKeys(keys), keys);
+    }
+
+    void moveTouchesOneKey()
+    {
+        // the last one moved to the front, and one moved down
+        for (const QVector<int>& keys : { QVector<int>{ 4096, 1024, 2048, 3072 },
+                                          QVector<int>{ 1024, 3072, 4096, 2048, 5120 } }) {
+            const QVector<int> re = KatalogListView::gapSortKeys(keys);
+            QVERIFY(increasing(re));
+            QCOMPARE(changed(keys, re), 1);
+        }
+
+        // an item with a key out of order at the end
+        QCOMPARE(KatalogListView::gapSortKeys({ 1024, 2048, 0 }), QVector<int>({ 1024, 2048, 3072 }));
+    }
+
+    void renumberWithoutGap()
+    {
+        // the keys written before had no gaps
+        const QVector<int> re = KatalogListView::gapSortKeys({ 0, 2, 1, 3 });
+        QCOMPARE(re, QVector<int>({ 1024, 2048, 3072, 4096 }));
+
+        // the same keys for all
+        QVERIFY(increasing(KatalogListView::gapSortKeys({ 0, 0, 0, 0 })));
+    }
+
+    void repeatedMoves()
+    {
+        QVector<int> keys;
+        for (int i = 0; i < 50; i++) {
+            keys.append((i + 1) * KatalogListView::SortKeyGap);
+        }
+        // move the item at the end to the front again and again
+        for (int round = 0; round < 30; round++) {
+            keys.prepend(keys.takeLast());
+            const QVector<int> re = KatalogListView::gapSortKeys(keys);
+            QVERIFY(increasing(re));
+            if (round < 9) {
+                // there is room in front of the first key for some moves
+                QCOMPARE(changed(keys, re), 1);
+            }
+            keys = re;
+        }
+    }
+};
+
+QTEST_MAIN(T_KatalogListView)
+#include "t_kataloglistview.moc"
@@ -0,0 +1,103 @@
+#include <QTest>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QDateTime>
+
+#include "pdfrendercache.h"
+
+namespace {
+
+void writeFile(const QString& name, const QByteArray& content)
+{
+    QFile f(name);
+    f.open(QIODevice::WriteOnly);
+    f.write(content);
+    f.close();
+}
+
+// the modification time is the last usage of a cache entry
+bool setLastUsed(const QString& cacheDir, const QByteArray& key, const QDateTime& dt)
+{
+    QFile f(QString("%1/%2.pdf").arg(cacheDir, QString::fromLatin1(key)));
+    if (!f.open(QIODevice::ReadWrite)) {
+        return false;
+    }
+    return f.setFileTime(dt, QFileDevice::FileModificationTime);
+}
+
+}
+
+class T_PdfRenderCache : public QObject {
+    Q_OBJECT
+private slots:
+    void initTestCase()
+    {
+        QVERIFY(_tmp.isValid());
+        _tmplFile = _tmp.filePath("invoice.gtmpl");
+        writeFile(_tmplFile, "<html>{{doc.ident}}</html>");
+    }
+
+    void keyDependsOnInput()
+    {
+        const QByteArray k1 = PdfRenderCache::key("expanded", QStringList() << _tmplFile, "0");
+        QCOMPARE(PdfRenderCache::key("expanded", QStringList() << _tmplFile, "0"), k1);
+
+        QVERIFY(PdfRenderCache::key("expanded2", QStringList() << _tmplFile, "0") != k1);
+        QVERIFY(PdfRenderCache::key("expanded", QStringList() << _tmplFile, "1") != k1);
+
+        writeFile(_tmplFile, "<html>{{doc.ident}} changed</html>");
+        QVERIFY(PdfRenderCache::key("expanded", QStringList() << _tmplFile, "0") != k1);
+    }
+
+    void storeAndLookup()
+    {
+        PdfRenderCache cache(1024*1024, _tmp.filePath("cache"));
+        const QByteArray key = PdfRenderCache::key("doc1", QStringList());
+
+        QVERIFY(cache.lookup(key).isEmpty());
+
+        const QString pdf = _tmp.filePath("doc1.pdf");
+        writeFile(pdf, "%PDF-1.4 doc1");
+        QVERIFY(cache.store(key, pdf));
+
+        const QString cached = cache.lookup(key);
+        QVERIFY(!cached.isEmpty());
+        QFile f(cached);
+        QVERIFY(f.open(QIODevice::ReadOnly));
+        QCOMPARE(f.readAll(), QByteArray("%PDF-1.4 doc1"));
+    }
+
+    void evictLeastRecentlyUsed()
+    {
+        // room for two documents of 100 bytes
+        const QString dir = _tmp.filePath("lru");
+        PdfRenderCache cache(250, dir);
+        const QString pdf = _tmp.filePath("lru.pdf");
+        writeFile(pdf, QByteArray(100, 'x'));
+
+        const QByteArray k1 = PdfRenderCache::key("1", QStringList());
+        const QByteArray k2 = PdfRenderCache::key("2", QStringList());
+        const QByteArray k3 = PdfRenderCache::key("3", QStringList());
+
+        const QDateTime now = QDateTime::currentDateTime();
+        QVERIFY(cache.store(k1, pdf));
+        QVERIFY(setLastUsed(dir, k1, now.addSecs(-300)));
+        QVERIFY(cache.store(k2, pdf));
+        QVERIFY(setLastUsed(dir, k2, now.addSecs(-200)));
+        // use the first one, so that the second one is the oldest now
+        QVERIFY(!cache.lookup(k1).isEmpty());
+        QVERIFY(cache.store(k3, pdf));
+
+        QVERIFY(!cache.lookup(k1).isEmpty());
+        QVERIFY(cache.lookup(k2).isEmpty());
+        QVERIFY(!cache.lookup(k3).isEmpty());
+    }
+
+private:
+    QTemporaryDir _tmp;
+    QString _tmplFile;
+};
+
+QTEST_MAIN(T_PdfRenderCache)
+#include "t_pdfrendercache.moc"
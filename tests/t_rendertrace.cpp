@@ -0,0 +1,107 @@
+#include <QTest>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+
+#include "rendertrace.h"
+
+class T_RenderTrace : public QObject {
+    Q_OBJECT
+private slots:
+    void init()
+    {
+        RenderTrace::self()->setEnabled(false);
+        RenderTrace::self()->clear();
+    }
+
+    void cleanup()
+    {
+        init();
+    }
+
+    void disabled()
+    {
+        RenderTrace trace;
+        trace.setEnabled(false);
+        QCOMPARE(trace.now(), qint64(-1));
+
+        trace.addSpan("Template expansion", "ident", "invoice.gtmpl", trace.now());
+        QVERIFY(!trace.summary().contains("Template expansion"));
+    }
+
+    void perInstance()
+    {
+        RenderTrace trace;
+        trace.setEnabled(true);
+        QVERIFY(trace.isEnabled());
+        QVERIFY(!RenderTrace::self()->isEnabled());
+        QCOMPARE(RenderTrace::self()->now(), qint64(-1));
+    }
+
+    void chromeTrace()
+    {
+        RenderTrace trace;
+        trace.setEnabled(true);
+
+        const qint64 start = trace.now();
+        QVERIFY(start >= 0);
+        trace.addSpan("ArchDoc load", "20210815-1", "/usr/share/kraft/reports/invoice.gtmpl", start);
+        trace.addSpan("Conversion", "20210815-1", "/usr/share/kraft/reports/invoice.gtmpl", start);
+        trace.addSpan("Conversion", "20210815-2", "/usr/share/kraft/reports/invoice.gtmpl", start);
+        trace.setEnabled(false);
+
+        const QString summary = trace.summary();
+        QVERIFY(summary.contains("of 2 documents"));
+        QVERIFY(summary.contains("ArchDoc load"));
+
+        QTemporaryDir dir;
+        const QString file = dir.filePath("trace.json");
+        QVERIFY(trace.writeChromeTrace(file));
+
+        QFile f(file);
+        QVERIFY(f.open(QIODevice::ReadOnly));
+        const QJsonArray events = QJsonDocument::fromJson(f.readAll()).object().value("traceEvents").toArray();
+        QCOMPARE(events.size(), 3);
+
+        const QJsonObject ev = events.at(0).toObject();
+        QCOMPARE(ev.value("ph").toString(), QStringLiteral("X"));
+        QCOMPARE(ev.value("name").toString(), QStringLiteral("ArchDoc load"));
+        QCOMPARE(ev.value("args").toObject().value("template").toString(), QStringLiteral("invoice.gtmpl"));
+        // one row per document
+        QCOMPARE(events.at(1).toObject().value("tid"), ev.value("tid"));
+        QVERIFY(events.at(2).toObject().value("tid") != ev.value("tid"));
+    }
+
+    void boundedSpans()
+    {
+        RenderTrace trace;
+        trace.setEnabled(true);
+        trace.setMaxSpans(2);
+
+        const qint64 start = trace.now();
+        for (int i = 1; i <= 5; i++) {
+            trace.addSpan("Conversion", QString("20210815-%1").arg(i), "invoice.gtmpl", start);
+        }
+
+        // the summary covers all spans
+        const QString summary = trace.summary();
+        QVERIFY(summary.contains("of 5 documents"));
+
+        // only the latest spans are kept for the trace
+        QTemporaryDir dir;
+        const QString file = dir.filePath("trace.json");
+        QVERIFY(trace.writeChromeTrace(file));
+        QFile f(file);
+        QVERIFY(f.open(QIODevice::ReadOnly));
+        const QJsonArray events = QJsonDocument::fromJson(f.readAll()).object().value("traceEvents").toArray();
+        QCOMPARE(events.size(), 2);
+        QCOMPARE(events.at(0).toObject().value("args").toObject().value("ident").toString(), QStringLiteral("20210815-4"));
+        QCOMPARE(events.at(1).toObject().value("args").toObject().value("ident").toString(), QStringLiteral("20210815-5"));
+    }
+};
+
+QTEST_MAIN(T_RenderTrace)
+#include "t_rendertrace.moc"
@@ -0,0 +1,528 @@
+#include <algorithm>
+
+#include <QTest>
+#include <QObject>
+#include <QSql>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+
+#include "kraftdb.h"
+#include "katalogman.h"
+#include "templkatalog.h"
+#include "floskeltemplate.h"
+#include "timecalcpart.h"
+#include "fixcalcpart.h"
+#include "materialcalcpart.h"
+#include "matkatalog.h"
+#include "stockmaterial.h"
+#include "templatesaverdb.h"
+#include "materialsaverdb.h"
+#include "kataloglistview.h"
+
+namespace {
+
+void exec(const QString& sql)
+{
+    QSqlQuery q;
+    if (!q.exec(sql)) {
+        qDebug() << "Failed:" << sql << q.lastError().text();
+    }
+}
+
+// The tables with the columns of the current schema, as the migrations
+// are only found with KRAFT_HOME set.
+void init_test_db()
+{
+    const QString dbName("__test_templkatalog.db");
+
+    QFile::remove(dbName);
+
+    KraftDB::self()->dbConnect("QSQLITE", dbName, QString(), QString(), QString());
+
+    exec("CREATE TABLE CatalogSet(catalogSetID INTEGER PRIMARY KEY ASC autoincrement, name VARCHAR(255), "
+         "description VARCHAR(255), catalogType VARCHAR(64), sortKey INT NOT NULL)");
+    exec("CREATE TABLE CatalogChapters(chapterID INTEGER PRIMARY KEY ASC autoincrement, catalogSetID INT NOT NULL, "
+         "chapter VARCHAR(255), parentChapter INT, description TEXT, sortKey INT NOT NULL)");
+    exec("CREATE TABLE Catalog(TemplID INTEGER PRIMARY KEY ASC autoincrement, chapterID INT NOT NULL default 1, "
+         "unitID INT NOT NULL, Floskel TEXT, Gewinn DECIMAL(6,2) default 0, zeitbeitrag TINYINT default 1, "
+         "enterDatum DATETIME, modifyDatum TIMESTAMP(14), Preisart INT NOT NULL default 1, "
+         "EPreis DECIMAL(10,2) default 0, sortKey INT default 0, calcPrice DECIMAL(10,2))");
+    exec("CREATE TABLE CalcTime(TCalcID INTEGER PRIMARY KEY ASC autoincrement, TemplID INT NOT NULL, "
+         "name VARCHAR(255), minutes INT default 0, percent INT default 0, stdHourSet INT default 0, "
+         "allowGlobal INT default 1, timeUnit INT default 0)");
+    exec("CREATE TABLE CalcFixed(FCalcID INTEGER PRIMARY KEY ASC autoincrement, TemplID INT NOT NULL, "
+         "name VARCHAR(255), amount DECIMAL(10,2) default 1.0, price DECIMAL(10,2), percent INT default 0)");
+    exec("CREATE TABLE CalcMaterials(MCalcID INTEGER PRIMARY KEY ASC autoincrement, TemplID INT NOT NULL, "
+         "materialID INT, percent INT default 0, amount DECIMAL(10,2))");
+    exec("CREATE TABLE catItemUsage(catId INT NOT NULL, itemId INT NOT NULL, usageCount INT default 0, "
+         "lastUsed DATETIME, PRIMARY KEY(catId, itemId))");
+    exec("CREATE TABLE stdSaetze(stdSaetzeID INTEGER PRIMARY KEY ASC autoincrement, name VARCHAR(255), "
+         "price DECIMAL(10,2), sortKey INT)");
+    exec("CREATE TABLE stockMaterial(matID INTEGER PRIMARY KEY ASC autoincrement, chapterID INT, material TEXT, "
+         "unitID INT, perPack DECIMAL(10,2), priceIn DECIMAL(10,2), priceOut DECIMAL(10,2), "
+         "modifyDate TIMESTAMP, enterDate DATETIME, sortKey INT default 0)");
+
+    exec("INSERT INTO CatalogSet (name, description, catalogType, sortKey) VALUES ('Test', 'Test catalog', 'TemplCatalog', 1)");
+    exec("INSERT INTO CatalogSet (name, description, catalogType, sortKey) VALUES ('Other', 'Other catalog', 'TemplCatalog', 2)");
+    exec("INSERT INTO CatalogChapters (catalogSetID, chapter, parentChapter, sortKey) VALUES (1, 'Walls', 0, 1)");
+    exec("INSERT INTO CatalogChapters (catalogSetID, chapter, parentChapter, sortKey) VALUES (1, 'Floors', 0, 2)");
+    exec("INSERT INTO CatalogChapters (catalogSetID, chapter, parentChapter, sortKey) VALUES (2, 'Roofs', 0, 1)");
+    exec("INSERT INTO stdSaetze (name, price, sortKey) VALUES ('Geselle', 34.00, 1)");
+    exec("INSERT INTO stdSaetze (name, price, sortKey) VALUES ('Meister', 39.00, 2)");
+
+    // the templates are not in the order of their ids, and the parts of
+    // the templates are interleaved
+    exec("INSERT INTO Catalog (TemplID, chapterID, unitID, Floskel, Gewinn, zeitbeitrag, Preisart, EPreis, sortKey) "
+         "VALUES (1, 2, 1, 'Tiles', 10, 1, 2, 0, 2)");
+    exec("INSERT INTO Catalog (TemplID, chapterID, unitID, Floskel, Gewinn, zeitbeitrag, Preisart, EPreis, sortKey) "
+         "VALUES (2, 1, 2, 'Plaster', 5, 0, 1, 12.5, 1)");
+    exec("INSERT INTO Catalog (TemplID, chapterID, unitID, Floskel, Gewinn, zeitbeitrag, Preisart, EPreis, sortKey) "
+         "VALUES (3, 2, 1, 'Parquet', 0, 1, 2, 0, 1)");
+    exec("INSERT INTO Catalog (TemplID, chapterID, unitID, Floskel, Gewinn, zeitbeitrag, Preisart, EPreis, sortKey) "
+         "VALUES (4, 3, 1, 'Shingles', 0, 1, 2, 0, 1)");
+
+    exec("INSERT INTO CalcTime (TemplID, name, minutes, percent, stdHourSet, allowGlobal, timeUnit) VALUES (3, 'Lay', 30, 0, 2, 1, 0)");
+    exec("INSERT INTO CalcTime (TemplID, name, minutes, percent, stdHourSet, allowGlobal, timeUnit) VALUES (1, 'Cut', 10, 5, 1, 0, 0)");
+    exec("INSERT INTO CalcTime (TemplID, name, minutes, percent, stdHourSet, allowGlobal, timeUnit) VALUES (3, 'Polish', 2, 0, 1, 1, 2)");
+    exec("INSERT INTO CalcTime (TemplID, name, minutes, percent, stdHourSet, allowGlobal, timeUnit) VALUES (4, 'Other', 2, 0, 1, 1, 0)");
+    exec("INSERT INTO CalcFixed (TemplID, name, amount, price, percent) VALUES (1, 'Glue', 2, 3.5, 0)");
+    exec("INSERT INTO CalcFixed (TemplID, name, amount, price, percent) VALUES (3, 'Disposal', 1, 20, 10)");
+    exec("INSERT INTO CalcMaterials (TemplID, materialID, percent, amount) VALUES (1, 7, 0, 1.5)");
+    exec("INSERT INTO CalcMaterials (TemplID, materialID, percent, amount) VALUES (3, 8, 5, 3)");
+
+    // the materials of a chapter are not in the order of their ids
+    exec("INSERT INTO stockMaterial (matID, chapterID, material, unitID, perPack, priceIn, priceOut, sortKey) "
+         "VALUES (7, 5, 'Tile glue', 1, 1, 8.00, 10.00, 2)");
+    exec("INSERT INTO stockMaterial (matID, chapterID, material, unitID, perPack, priceIn, priceOut, sortKey) "
+         "VALUES (8, 5, 'Oak boards', 1, 2, 15.00, 20.00, 1)");
+    exec("INSERT INTO stockMaterial (matID, chapterID, material, unitID, perPack, priceIn, priceOut, sortKey) "
+         "VALUES (9, 6, 'Nails', 1, 100, 3.00, 4.00, 1)");
+
+    exec("INSERT INTO catItemUsage (catId, itemId, usageCount, lastUsed) VALUES (1, 3, 7, '2026-10-01 12:00:00')");
+    exec("INSERT INTO catItemUsage (catId, itemId, usageCount, lastUsed) VALUES (2, 1, 99, '2026-10-02 12:00:00')");
+}
+
+}
+
+class T_TemplKatalog : public QObject {
+    Q_OBJECT
+private slots:
+    void initTestCase()
+    {
+        // the registered catalogs write their snapshot to the cache dir
+        QStandardPaths::setTestModeEnabled(true);
+        init_test_db();
+    }
+
+    void sameAsPerTemplateLoader()
+    {
+        TemplKatalog perTemplate("Test");
+        QCOMPARE(perTemplate.loadPerTemplate(), 3);
+
+        TemplKatalog bulk("Test");
+        QCOMPARE(bulk.load(), 3);
+
+        const QList<FloskelTemplate*> expected = perTemplate.getFlosTemplates(1) + perTemplate.getFlosTemplates(2);
+        const QList<FloskelTemplate*> loaded = bulk.getFlosTemplates(1) + bulk.getFlosTemplates(2);
+        QCOMPARE(loaded.count(), expected.count());
+
+        for (int i = 0; i < expected.count(); i++) {
+            compareTemplates(loaded.at(i), expected.at(i));
+        }
+    }
+
+    void usageOfOwnCatalog()
+    {
+        TemplKatalog bulk("Test");
+        bulk.load();
+
+        for (FloskelTemplate *flos : bulk.getFlosTemplates(2)) {
+            if (flos->getTemplID() == 3) {
+                QCOMPARE(flos->useCounter(), 7);
+            } else {
+                // the usage of another catalog does not count
+                QCOMPARE(flos->useCounter(), 0);
+            }
+        }
+    }
+
+    void chapterIndex()
+    {
+        TemplKatalog kat("Test");
+        kat.load();
+
+        QCOMPARE(kat.chapterName(dbID(2)), QStringLiteral("Floors"));
+        QCOMPARE(kat.chapterID(QStringLiteral("Walls")).toInt(), 1);
+        QVERIFY(!kat.chapterID(QStringLiteral("Roofs")).isOk());
+
+        // in the sort order within the chapter
+        FloskelTemplateList floors = kat.getFlosTemplates(2);
+        QCOMPARE(floors.count(), 2);
+        QCOMPARE(floors.at(0)->getTemplID(), 3);
+        QCOMPARE(floors.at(1)->getTemplID(), 1);
+
+        // moving a template to another chapter updates the index
+        floors.at(1)->setChapterId(dbID(1), false);
+        kat.invalidateChapterIndex();
+        QCOMPARE(kat.getFlosTemplates(2).count(), 1);
+        QCOMPARE(kat.getFlosTemplates(1).count(), 2);
+        QCOMPARE(kat.getFlosTemplates(1).last()->getTemplID(), 1);
+        QVERIFY(kat.getFlosTemplates(3).isEmpty());
+    }
+
+    void materialIndex()
+    {
+        MatKatalog *mat = MaterialCalcPart::materialCatalog();
+        QVERIFY(mat);
+
+        QVERIFY(mat->materialFromId(8));
+        QCOMPARE(mat->materialFromId(8)->getText(), QStringLiteral("Oak boards"));
+        QVERIFY(!mat->materialFromId(42));
+
+        const StockMaterialList chapter = mat->getRecordList(5);
+        QCOMPARE(chapter.count(), 2);
+        QCOMPARE(chapter.at(0)->getID(), 8);
+        QCOMPARE(chapter.at(1)->getID(), 7);
+        QCOMPARE(mat->getRecordList(6).count(), 1);
+        QVERIFY(mat->getRecordList(7).isEmpty());
+
+        // the parts point to the materials of the catalog
+        TemplKatalog kat("Test");
+        kat.load();
+        for (FloskelTemplate *flos : kat.getFlosTemplates(2)) {
+            for (CalcPart *cp : flos->getCalcPartsList(KALKPART_MATERIAL)) {
+                MaterialCalcPart *mp = static_cast<MaterialCalcPart*>(cp);
+                QVERIFY(mp->getMaterial());
+                QCOMPARE(mp->getName(), mp->getMaterial()->getText());
+            }
+        }
+    }
+
+    void storedPriceWithoutParts()
+    {
+        // the previous load stored the prices of the calculated templates
+        TemplKatalog kat("Test");
+        kat.load();
+
+        for (FloskelTemplate *flos : kat.getFlosTemplates(2)) {
+            QVERIFY(flos->hasStoredPrice());
+            QVERIFY(!flos->calcPartsLoaded());
+
+            const long stored = flos->unitPrice().toLong();
+            QVERIFY(!flos->calcPartsLoaded());
+
+            // the parts load on demand and result in the same price
+            QVERIFY(!flos->getCalcPartsList().isEmpty());
+            QVERIFY(flos->calcPartsLoaded());
+            QCOMPARE(flos->unitPrice().toLong(), stored);
+        }
+    }
+
+    void hourRateChangeDropsStoredPrice()
+    {
+        long before = 0;
+        {
+            TemplKatalog kat("Test");
+            kat.load();
+            for (FloskelTemplate *flos : kat.getFlosTemplates(2)) {
+                if (flos->getTemplID() == 3) {
+                    before = flos->unitPrice().toLong();
+                }
+            }
+        }
+
+        exec("UPDATE stdSaetze SET price=60.00 WHERE stdSaetzeID=2");
+        TemplKatalog::hourRateChanged(dbID(2));
+
+        QSqlQuery q("SELECT TemplID, calcPrice FROM Catalog WHERE TemplID IN (1, 3) ORDER BY TemplID");
+        QVERIFY(q.next());
+        QVERIFY(!q.value(1).isNull());
+        QVERIFY(q.next());
+        // only template 3 uses the rate
+        QVERIFY(q.value(1).isNull());
+
+        TemplKatalog kat("Test");
+        kat.load();
+        for (FloskelTemplate *flos : kat.getFlosTemplates(2)) {
+            QVERIFY(flos->hasStoredPrice());
+            if (flos->getTemplID() == 3) {
+                QVERIFY(flos->unitPrice().toLong() > before);
+            }
+        }
+    }
+
+    void dependencyIndex()
+    {
+        TemplKatalog kat("Test");
+        kat.load();
+
+        QList<int> ids;
+        for (FloskelTemplate *flos : kat.templatesUsingRate(dbID(1))) {
+            ids.append(flos->getTemplID());
+        }
+        std::sort(ids.begin(), ids.end());
+        QCOMPARE(ids, QList<int>() << 1 << 3);
+
+        QCOMPARE(kat.templatesUsingRate(dbID(2)).count(), 1);
+        QCOMPARE(kat.templatesUsingRate(dbID(2)).first()->getTemplID(), 3);
+        QCOMPARE(kat.templatesUsingMaterial(dbID(7)).count(), 1);
+        QCOMPARE(kat.templatesUsingMaterial(dbID(7)).first()->getTemplID(), 1);
+        QVERIFY(kat.templatesUsingMaterial(dbID(99)).isEmpty());
+
+        // reading the index does not load any calculation parts
+        for (FloskelTemplate *flos : kat.getFlosTemplates(2)) {
+            QVERIFY(!flos->calcPartsLoaded());
+        }
+    }
+
+    void rateChangeUpdatesLoadedCatalog()
+    {
+        TemplKatalog *kat = new TemplKatalog("Test");
+        KatalogMan::self()->registerKatalog(kat);
+        QCOMPARE(TemplKatalog::rateUsage(dbID(2)), 1);
+
+        long before = 0;
+        long other = 0;
+        for (FloskelTemplate *flos : kat->getFlosTemplates(2)) {
+            if (flos->getTemplID() == 3) {
+                before = flos->unitPrice().toLong();
+            } else {
+                other = flos->unitPrice().toLong();
+            }
+        }
+
+        exec("UPDATE stdSaetze SET price=80.00 WHERE stdSaetzeID=2");
+        QCOMPARE(TemplKatalog::hourRateChanged(dbID(2)), 1);
+
+        for (FloskelTemplate *flos : kat->getFlosTemplates(2)) {
+            QSqlQuery q(QString("SELECT calcPrice FROM Catalog WHERE TemplID=%1").arg(flos->getTemplID()));
+            QVERIFY(q.next());
+            if (flos->getTemplID() == 3) {
+                QVERIFY(flos->calcPartsLoaded());
+                QVERIFY(flos->unitPrice().toLong() > before);
+            } else {
+                // not affected, still the stored price without parts
+                QVERIFY(!flos->calcPartsLoaded());
+                QCOMPARE(flos->unitPrice().toLong(), other);
+            }
+            QCOMPARE(Geld(q.value(0).toDouble()).toLong(), flos->unitPrice().toLong());
+        }
+    }
+
+    void rateChangeInOtherCatalogs()
+    {
+        // the Test catalog is registered and loaded by the test before
+        QVERIFY(KatalogMan::self()->getKatalog("Test"));
+        {
+            // stores the price of template 4 in the Other catalog
+            TemplKatalog other("Other");
+            other.load();
+        }
+        QSqlQuery stored("SELECT calcPrice FROM Catalog WHERE TemplID=4");
+        QVERIFY(stored.next());
+        QVERIFY(!stored.value(0).isNull());
+
+        // templates 1 and 3 of Test and 4 of Other use the rate
+        QCOMPARE(TemplKatalog::rateUsage(dbID(1)), 3);
+
+        exec("UPDATE stdSaetze SET price=36.00 WHERE stdSaetzeID=1");
+        QCOMPARE(TemplKatalog::hourRateChanged(dbID(1)), 3);
+
+        // not loaded, computed again on the next load
+        QSqlQuery dropped("SELECT calcPrice FROM Catalog WHERE TemplID=4");
+        QVERIFY(dropped.next());
+        QVERIFY(dropped.value(0).isNull());
+
+        // all registered catalogs get their prices computed
+        TemplKatalog *other = new TemplKatalog("Other");
+        KatalogMan::self()->registerKatalog(other);
+        exec("UPDATE stdSaetze SET price=38.00 WHERE stdSaetzeID=1");
+        QCOMPARE(TemplKatalog::hourRateChanged(dbID(1)), 3);
+
+        for (FloskelTemplate *flos : other->getFlosTemplates(3)) {
+            QSqlQuery q(QString("SELECT calcPrice FROM Catalog WHERE TemplID=%1").arg(flos->getTemplID()));
+            QVERIFY(q.next());
+            QVERIFY(!q.value(0).isNull());
+            QCOMPARE(Geld(q.value(0).toDouble()).toLong(), flos->unitPrice().toLong());
+        }
+    }
+
+    void severalRatesInOneUpdate()
+    {
+        exec("UPDATE stdSaetze SET price=40.00 WHERE stdSaetzeID=1");
+        exec("UPDATE stdSaetze SET price=70.00 WHERE stdSaetzeID=2");
+
+        // template 3 uses both rates and counts once
+        QCOMPARE(TemplKatalog::hourRatesChanged(QList<dbID>() << dbID(1) << dbID(2)), 3);
+
+        for (const QString& name : { QStringLiteral("Test"), QStringLiteral("Other") }) {
+            TemplKatalog *kat = static_cast<TemplKatalog*>(KatalogMan::self()->getKatalog(name));
+            QVERIFY(kat);
+            for (FloskelTemplate *flos : kat->templatesUsingRate(dbID(1))) {
+                QSqlQuery q(QString("SELECT calcPrice FROM Catalog WHERE TemplID=%1").arg(flos->getTemplID()));
+                QVERIFY(q.next());
+                QVERIFY(flos->hasStoredPrice());
+                QCOMPARE(Geld(q.value(0).toDouble()).toLong(), flos->unitPrice().toLong());
+            }
+        }
+    }
+
+    void snapshot()
+    {
+        QTemporaryDir dir;
+        const QString file = dir.filePath("catalog.snapshot");
+
+        TemplKatalog sql("Test");
+        sql.load();
+        QVERIFY(sql.writeSnapshot(file));
+
+        TemplKatalog snap("Test");
+        QVERIFY(snap.loadSnapshot(file));
+        const QList<FloskelTemplate*> expected = sql.getFlosTemplates(1) + sql.getFlosTemplates(2);
+        const QList<FloskelTemplate*> loaded = snap.getFlosTemplates(1) + snap.getFlosTemplates(2);
+        QCOMPARE(loaded.count(), expected.count());
+        for (int i = 0; i < expected.count(); i++) {
+            QVERIFY(!loaded.at(i)->calcPartsLoaded());
+            QCOMPARE(loaded.at(i)->sortKey(), expected.at(i)->sortKey());
+            compareTemplates(loaded.at(i), expected.at(i));
+        }
+
+        // any change of the catalog makes the snapshot outdated
+        exec("UPDATE Catalog SET sortKey=sortKey+1 WHERE TemplID=1");
+        TemplKatalog changed("Test");
+        QVERIFY(!changed.loadSnapshot(file));
+        exec("UPDATE Catalog SET sortKey=sortKey-1 WHERE TemplID=1");
+
+        exec("UPDATE CatalogChapters SET chapter='Wall' WHERE chapterID=1");
+        TemplKatalog renamed("Test");
+        QVERIFY(!renamed.loadSnapshot(file));
+        exec("UPDATE CatalogChapters SET chapter='Walls' WHERE chapterID=1");
+
+        TemplKatalog again("Test");
+        QVERIFY(again.loadSnapshot(file));
+    }
+
+    void usageIsWrittenBehind()
+    {
+        TemplKatalog kat("Test");
+        kat.load();
+
+        QCOMPARE(kat.recordUsage(3).first, 8);
+        QCOMPARE(kat.recordUsage(1).first, 1);
+        QCOMPARE(kat.recordUsage(1).first, 2);
+        QVERIFY(kat.hasPendingUsage());
+        // not yet in the database
+        QCOMPARE(storedUsage(1, 3), 7);
+        QCOMPARE(storedUsage(1, 1), -1);
+        QCOMPARE(kat.usageCount(3).first, 8);
+
+        QVERIFY(kat.flushUsage());
+        QVERIFY(!kat.hasPendingUsage());
+        QCOMPARE(storedUsage(1, 3), 8);
+        QCOMPARE(storedUsage(1, 1), 2);
+        QCOMPARE(storedUsage(2, 1), 99);
+
+        // counts that were written meanwhile are kept
+        exec("UPDATE catItemUsage SET usageCount=20 WHERE catId=1 AND itemId=3");
+        kat.recordUsage(3);
+        kat.load();
+        QCOMPARE(storedUsage(1, 3), 21);
+        for (FloskelTemplate *flos : kat.getFlosTemplates(2)) {
+            if (flos->getTemplID() == 3) {
+                QCOMPARE(flos->useCounter(), 21);
+            }
+        }
+    }
+
+    void freshItemGetsStoredSortKey()
+    {
+        FloskelTemplate fresh;
+        QCOMPARE(fresh.sortKey(), 0);
+        fresh.setText(QStringLiteral("Gutter"));
+        fresh.setChapterId(dbID(3), false);
+        TemplateSaverDB saver;
+        QVERIFY(saver.saveTemplate(&fresh));
+
+        // behind template 4, and the same key in memory and database
+        QCOMPARE(fresh.sortKey(), 1 + CatalogTemplate::SortKeyGap);
+        QSqlQuery q(QString("SELECT sortKey FROM Catalog WHERE TemplID=%1").arg(fresh.getTemplID()));
+        QVERIFY(q.next());
+        QCOMPARE(q.value(0).toInt(), fresh.sortKey());
+
+        // dropped in front of template 4, only the fresh one gets a new key
+        const QVector<int> re = KatalogListView::gapSortKeys({ fresh.sortKey(), 1 });
+        QVERIFY(re.at(0) != fresh.sortKey());
+        QVERIFY(re.at(0) < re.at(1));
+        QCOMPARE(re.at(1), 1);
+
+        StockMaterial mat(-1, 6, QStringLiteral("Screws"), 1, 100, Geld(2.0), Geld(3.0));
+        QCOMPARE(mat.sortKey(), 0);
+        QVERIFY(MaterialSaverDB::self()->saveTemplate(&mat));
+        QCOMPARE(mat.sortKey(), 1 + CatalogTemplate::SortKeyGap);
+        QSqlQuery m(QString("SELECT sortKey FROM stockMaterial WHERE matID=%1").arg(mat.getID()));
+        QVERIFY(m.next());
+        QCOMPARE(m.value(0).toInt(), mat.sortKey());
+    }
+
+private:
+    int storedUsage(int catId, int itemId)
+    {
+        QSqlQuery q(QString("SELECT usageCount FROM catItemUsage WHERE catId=%1 AND itemId=%2").arg(catId).arg(itemId));
+        return q.next() ? q.value(0).toInt() : -1;
+    }
+
+    void compareTemplates(FloskelTemplate *t, FloskelTemplate *e)
+    {
+        QCOMPARE(t->getTemplID(), e->getTemplID());
+        QCOMPARE(t->getText(), e->getText());
+        QCOMPARE(t->chapterId().toInt(), e->chapterId().toInt());
+        QCOMPARE(t->calcKind(), e->calcKind());
+        QCOMPARE(t->getBenefit(), e->getBenefit());
+        QCOMPARE(t->manualPrice().toLong(), e->manualPrice().toLong());
+        QCOMPARE(t->hasTimeslice(), e->hasTimeslice());
+        QCOMPARE(t->useCounter(), e->useCounter());
+        QCOMPARE(t->lastUsedDate(), e->lastUsedDate());
+        QCOMPARE(t->unitPrice().toLong(), e->unitPrice().toLong());
+
+        const CalcPartList tp = t->getCalcPartsList();
+        const CalcPartList ep = e->getCalcPartsList();
+        QCOMPARE(tp.count(), ep.count());
+
+        for (int i = 0; i < ep.count(); i++) {
+            CalcPart *a = tp.at(i);
+            CalcPart *b = ep.at(i);
+            QCOMPARE(a->getType(), b->getType());
+            QCOMPARE(a->getDbID().toInt(), b->getDbID().toInt());
+            QCOMPARE(a->getTemplID().toInt(), b->getTemplID().toInt());
+            QCOMPARE(a->getName(), b->getName());
+            QCOMPARE(a->getProzentPlus(), b->getProzentPlus());
+            QCOMPARE(a->basisKosten().toLong(), b->basisKosten().toLong());
+            QCOMPARE(a->isDirty(), b->isDirty());
+
+            if (a->getType() == KALKPART_TIME) {
+                TimeCalcPart *ta = static_cast<TimeCalcPart*>(a);
+                TimeCalcPart *tb = static_cast<TimeCalcPart*>(b);
+                QCOMPARE(ta->duration(), tb->duration());
+                QCOMPARE(ta->timeUnit(), tb->timeUnit());
+                QCOMPARE(ta->globalStdSetAllowed(), tb->globalStdSetAllowed());
+                QCOMPARE(ta->getStundensatz().getId().toInt(), tb->getStundensatz().getId().toInt());
+            } else if (a->getType() == KALKPART_FIX) {
+                FixCalcPart *fa = static_cast<FixCalcPart*>(a);
+                FixCalcPart *fb = static_cast<FixCalcPart*>(b);
+                QCOMPARE(fa->getMenge(), fb->getMenge());
+                QCOMPARE(fa->unitPreis().toLong(), fb->unitPreis().toLong());
+            } else if (a->getType() == KALKPART_MATERIAL) {
+                MaterialCalcPart *ma = static_cast<MaterialCalcPart*>(a);
+                MaterialCalcPart *mb = static_cast<MaterialCalcPart*>(b);
+                QCOMPARE(ma->getCalcAmount(), mb->getCalcAmount());
+                QCOMPARE(ma->getMaterial(), mb->getMaterial());
+            }
+        }
+    }
+};
+
+QTEST_MAIN(T_TemplKatalog)
+#include "t_templkatalog.moc"
@@ -0,0 +1,105 @@
+#!/usr/bin/python3
+# -*- coding: utf-8 -*-
+#
+# Copyright 2026 Klaas Freitag <kraft@freisturz.de>
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy of this
+# software and associated documentation files (the "Software"), to deal in the Software
+# without restriction, including without limitation the rights to use, copy, modify,
+# merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to the following
+# conditions:
+#
+# The above copyright notice and this permission notice shall be included in all copies
+# or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+# INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+# PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+# HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+# OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+# SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+# Compares rendering RML documents with one erml2pdf.py process per document
+# against the erml2pdf.py server mode.
+#
+# The documents are the given RML files, for example expanded archived
+# documents, used round robin until the requested amount is rendered.
+# Without files, test1.trml next to this script is used.
+#
+import getopt
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+here = os.path.dirname(os.path.abspath(__file__))
+erml2pdf = os.path.join(here, 'erml2pdf.py')
+
+
+def render_processes(docs, outdir):
+    for i, doc in enumerate(docs):
+        out = os.path.join(outdir, 'proc_%d.pdf' % i)
+        subprocess.check_call([sys.executable, erml2pdf, '-o', out, doc])
+
+
+def render_server(docs, outdir):
+    server = subprocess.Popen([sys.executable, erml2pdf, '--server'],
+                              stdin=subprocess.PIPE, stdout=subprocess.PIPE,
+                              universal_newlines=True)
+    answer = json.loads(server.stdout.readline())
+    assert answer['status'] == 'ready', answer
+
+    for i, doc in enumerate(docs):
+        out = os.path.join(outdir, 'server_%d.pdf' % i)
+        server.stdin.write(json.dumps({'id': i, 'source': doc, 'output': out}) + '\n')
+        server.stdin.flush()
+        answer = json.loads(server.stdout.readline())
+        if answer['status'] != 'ok':
+            raise Exception('Rendering %s failed: %s' % (doc, answer.get('error')))
+
+    server.stdin.close()
+    server.wait()
+
+
+def benchmark(name, func, docs, outdir):
+    start = time.time()
+    func(docs, outdir)
+    elapsed = time.time() - start
+    print('%-10s %4d documents in %7.2f s, %6.1f ms per document'
+          % (name, len(docs), elapsed, 1000.0 * elapsed / len(docs)))
+    return elapsed
+
+
+def usage():
+    print('Usage: benchmark_erml2pdf.py [-n amount] [file.trml ...]')
+    print('')
+    print('Options:')
+    print('-n, --amount <n>     amount of documents to render per mode, default 100')
+    sys.exit(0)
+
+
+if __name__ == "__main__":
+    try:
+        opts, args = getopt.getopt(sys.argv[1:], "hn:", ["help", "amount="])
+    except getopt.GetoptError as err:
+        print(str(err))
+        usage()
+
+    amount = 100
+    for o, a in opts:
+        if o in ("-h", "--help"):
+            usage()
+        elif o in ("-n", "--amount"):
+            amount = int(a)
+
+    files = args or [os.path.join(here, 'test1.trml')]
+    docs = [files[i % len(files)] for i in range(amount)]
+
+    outdir = tempfile.mkdtemp(prefix='erml2pdf_bench_')
+    tProc = benchmark('processes', render_processes, docs, outdir)
+    tServer = benchmark('server', render_server, docs, outdir)
+    print('Speedup of the server mode: %.1fx' % (tProc / tServer))
+    print('Output in ' + outdir)
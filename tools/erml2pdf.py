@@ -31,6 +31,7 @@ import shlex
 import tempfile
 import getopt
 import re
+import json
 
 # StringIO is not longer separate in python3, but in io
 try:
@@ -300,6 +301,21 @@ class _rml_styles(object):
         return self._para_style_update(style, node)
 
 
+# Fonts registered with reportlab and parsed stylesheets, keyed by their
+# source. Both are kept for the lifetime of the process, which matters in
+# server mode where many documents share the same template.
+_registered_fonts = set()
+_styles_cache = {}
+
+def _styles_get(nodes):
+    key = ''.join([node.toxml() for node in nodes])
+    styles = _styles_cache.get(key)
+    if styles is None:
+        styles = _rml_styles(nodes)
+        _styles_cache[key] = styles
+    return styles
+
+
 class _rml_doc(object):
 
     def __init__(self, data):
@@ -315,7 +331,11 @@ class _rml_doc(object):
             for font in node.getElementsByTagName('registerFont'):
                 name = font.getAttribute('fontName').encode('ascii')
                 fname = font.getAttribute('fontFile').encode('ascii')
+                # in server mode, fonts stay registered between documents
+                if (name, fname) in _registered_fonts:
+                    continue
                 pdfmetrics.registerFont(TTFont(name, fname))
+                _registered_fonts.add((name, fname))
                 addMapping(name, 0, 0, name)  # normal
                 addMapping(name, 0, 1, name)  # italic
                 addMapping(name, 1, 0, name)  # bold
@@ -327,7 +347,7 @@ class _rml_doc(object):
             self.docinit(el)
 
         el = self.dom.documentElement.getElementsByTagName('stylesheet')
-        self.styles = _rml_styles(el)
+        self.styles = _styles_get(el)
 
         el = self.dom.documentElement.getElementsByTagName('template')
         if len(el):
@@ -879,11 +899,67 @@ def parseString(data):
     r.render(fp)
     return fp.getvalue()
 
+def renderJob(job):
+    "Renders one server mode job to its output file."
+    if 'data' in job:
+        content = job['data']
+    else:
+        with open(job['source'], 'r') as fh:
+            content = fh.read()
+    pdf = parseString(content)
+
+    # The watermark is merged the same way as Kraft does with watermarkpdf.py
+    # for the documents converted by separate processes, but the parsed
+    # watermark file is cached between the jobs.
+    watermarkMode = str(job.get('watermarkMode', Mark.NOTHING))
+    watermarkFile = job.get('watermarkFile')
+    if watermarkMode != Mark.NOTHING and watermarkFile:
+        from watermarkpdf import PdfWatermark as CachedWatermark
+        pdf = CachedWatermark().watermarkStream(io.BytesIO(pdf), watermarkFile, watermarkMode)
+
+    with open(job['output'], 'wb') as outfile:
+        outfile.write(pdf)
+
+def serve():
+    """Server mode: Keeps reportlab, the fonts and the parsed stylesheets
+    loaded and renders jobs read from stdin, one JSON object per line:
+
+      {"id": 1, "source": "doc.rml", "output": "doc.pdf",
+       "watermarkMode": "1", "watermarkFile": "water.pdf"}
+
+    Instead of the source file name, the RML document can be passed in
+    the job as "data".
+
+    For each job a line {"id": 1, "status": "ok"} or
+    {"id": 1, "status": "error", "error": "message"} is written to stdout.
+    """
+    def reply(answer):
+        sys.stdout.write(json.dumps(answer) + '\n')
+        sys.stdout.flush()
+
+    reply({'status': 'ready', 'version': reportlab.Version})
+
+    for line in iter(sys.stdin.readline, ''):
+        line = line.strip()
+        if not line:
+            continue
+        jobId = None
+        try:
+            job = json.loads(line)
+            jobId = job.get('id')
+            renderJob(job)
+            reply({'id': jobId, 'status': 'ok'})
+        except Exception as err:
+            sys.stderr.write('erml2pdf: job %s failed: %s\n' % (jobId, err))
+            sys.stderr.flush()
+            reply({'id': jobId, 'status': 'error', 'error': str(err)})
+
 def erml2pdf_help():
     print( 'Usage: erml2pdf [options] input.rml > output.pdf')
     print( '')
     print( 'Tool to render a file of the xml based markup language RML to PDF')
     print( 'with option to merge another PDF file as watermark.')
+    print( 'With - as input file, the RML is read from standard input.')
     print( '')
     print( 'Options:')
     print( '-o, --output <file>           output file, instead of standard out')
@@ -893,13 +969,15 @@ def erml2pdf_help():
     print( '                              2 = watermark on all pages')
     print( '                              Note: a watermark file must be specified for 1, 2')
     print( '-w, --watermark-file <file>   watermark file, the first page is used.')
+    print( '-s, --server                  server mode: read jobs as JSON lines from stdin')
+    print( '                              and keep fonts and styles loaded between them.')
     print( '')
     sys.exit(0)
 
 if __name__=="__main__":
 
     try:
-        opts, args = getopt.getopt(sys.argv[1:], "ho:w:m:", ["help", "output=", "watermark-file=", "watermark-mode="])
+        opts, args = getopt.getopt(sys.argv[1:], "ho:w:m:s", ["help", "output=", "watermark-file=", "watermark-mode=", "server"])
     except(getopt.GetoptError, err):
         # print help information and exit:
         print( str(err)) # will print something like "option -a not recognized"
@@ -908,11 +986,14 @@ if __name__=="__main__":
     output = None
     watermarkFile = None
     watermarkMode = Mark.NOTHING
+    serverMode = False
 
     for o, a in opts:
         if o in ("-h", "--help"):
             erml2pdf_help()
             sys.exit()
+        elif o in ("-s", "--server"):
+            serverMode = True
         elif o in ("-o", "--output"):
             output = a
         elif o in ("-w", "--watermark-file"):
@@ -922,14 +1003,19 @@ if __name__=="__main__":
         else:
             assert False, "unhandled option"
     #
-    if len(args) == 0:
+    if serverMode:
+        serve()
+    elif len(args) == 0:
         # a input file needs to be there
         erml2pdf_help()
     else:
         # print ("Args:" + args[0])
         infile = args[0]
         # create the PDF with the help of reportlab
-        content = open(infile, 'r').read()
+        if infile == '-':
+            content = sys.stdin.read()
+        else:
+            content = open(infile, 'r').read()
         pdf = parseString( content )
        # apply the watermark if required
         # print "############ Watermark-Mode: " + watermarkMode
@@ -46,15 +46,34 @@ class Mark:
     ALL_PAGES  = "2"
 
 
+# Parsed watermark files, keyed by file name. The converter workers keep
+# them between documents, the modification time invalidates an entry.
+_watermarks = {}
+
+def watermarkReader(watermarkFile):
+    mtime = os.path.getmtime(watermarkFile)
+    cached = _watermarks.get(watermarkFile)
+    if cached and cached[0] == mtime:
+        return cached[1]
+
+    with open(watermarkFile, "rb") as fh:
+        reader = PdfFileReader(io.BytesIO(fh.read()))
+    _watermarks[watermarkFile] = (mtime, reader)
+    return reader
+
+
 class PdfWatermark:
     "Class to put a watermark from a PDF file on a PDF file"
 
     def watermark( self, pdfFile, watermarkFile, spec ):
+        with open(pdfFile, "rb") as fh:
+            return self.watermarkStream(fh, watermarkFile, spec)
+
+    def watermarkStream( self, pdfStream, watermarkFile, spec ):
         # Read the watermark- and document pdf file
-        watermark = PdfFileReader(open(watermarkFile, "rb"))
-        watermark_page = watermark.getPage(0)
+        watermark = watermarkReader(watermarkFile)
 
-        inputPdf = PdfFileReader( open(pdfFile, "rb"))
+        inputPdf = PdfFileReader( pdfStream )
         outputPdf = PdfFileWriter()
 
         # flag for the first page of the source file
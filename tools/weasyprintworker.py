@@ -0,0 +1,140 @@
+#!/usr/bin/python3
+# -*- coding: utf-8 -*-
+#
+# Copyright 2026 Klaas Freitag <kraft@freisturz.de>
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy of this
+# software and associated documentation files (the "Software"), to deal in the Software
+# without restriction, including without limitation the rights to use, copy, modify,
+# merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+# permit persons to whom the Software is furnished to do so, subject to the following
+# conditions:
+#
+# The above copyright notice and this permission notice shall be included in all copies
+# or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+# INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+# PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+# HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+# OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+# SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+# Long running worker that converts HTML documents to PDF with WeasyPrint.
+#
+# Kraft starts it once and sends one job per line as a JSON object on stdin:
+#
+#   {"id": 1, "source": "/tmp/doc.html", "output": "/x/doc.pdf",
+#    "baseUrls": ["/usr/share/kraft/reports", "/home/me/templates"],
+#    "watermarkMode": "1", "watermarkFile": "/x/water.pdf"}
+#
+# Instead of the source file name, the HTML document can be passed in the
+# job as "data". The watermark members are optional. If given, the watermark is merged
+# before the output file is written, see watermarkpdf.py for the modes.
+#
+# For every job, one JSON line is written to stdout:
+#
+#   {"id": 1, "status": "ok"}
+#   {"id": 1, "status": "error", "error": "message"}
+#
+# After startup, the worker writes {"status": "ready"}. It terminates when
+# stdin is closed. Log output goes to stderr only.
+#
+import io
+import json
+import os
+import sys
+
+try:
+    from urllib.parse import urlparse, unquote
+except ImportError:
+    from urlparse import urlparse
+    from urllib import unquote
+
+import weasyprint
+from weasyprint import HTML, default_url_fetcher
+
+try:
+    from weasyprint.text.fonts import FontConfiguration
+except ImportError:
+    from weasyprint.fonts import FontConfiguration
+
+
+class BaseUrlFetcher:
+    "Resolves relative resources against a list of base directories, in order."
+
+    def __init__(self, baseUrls):
+        self.bases = [os.path.abspath(b) for b in baseUrls if b]
+
+    def __call__(self, url):
+        parsed = urlparse(url)
+        if parsed.scheme == 'file' and len(self.bases) > 1:
+            path = unquote(parsed.path)
+            if not os.path.exists(path):
+                # WeasyPrint resolved it against the first base, try the others
+                rel = os.path.relpath(path, self.bases[0])
+                if not rel.startswith('..'):
+                    for base in self.bases[1:]:
+                        candidate = os.path.join(base, rel)
+                        if os.path.exists(candidate):
+                            url = 'file://' + candidate
+                            break
+        return default_url_fetcher(url)
+
+
+class Worker:
+    "Keeps the WeasyPrint modules and the font configuration loaded between jobs."
+
+    def __init__(self):
+        self.fontConfig = FontConfiguration()
+
+    def convert(self, job):
+        baseUrls = job.get('baseUrls', [])
+        baseUrl = None
+        if baseUrls:
+            baseUrl = os.path.join(baseUrls[0], '')
+
+        if 'data' in job:
+            html = HTML(string=job['data'], base_url=baseUrl,
+                        url_fetcher=BaseUrlFetcher(baseUrls))
+        else:
+            html = HTML(filename=job['source'], base_url=baseUrl,
+                        url_fetcher=BaseUrlFetcher(baseUrls))
+
+        watermarkMode = str(job.get('watermarkMode', '0'))
+        watermarkFile = job.get('watermarkFile')
+        if watermarkMode != '0' and watermarkFile:
+            # imported on demand, PyPDF2 is only required for watermarks
+            from watermarkpdf import PdfWatermark
+            pdf = html.write_pdf(font_config=self.fontConfig)
+            pdf = PdfWatermark().watermarkStream(io.BytesIO(pdf), watermarkFile, watermarkMode)
+            with open(job['output'], 'wb') as fh:
+                fh.write(pdf)
+        else:
+            html.write_pdf(job['output'], font_config=self.fontConfig)
+
+    def reply(self, answer):
+        sys.stdout.write(json.dumps(answer) + '\n')
+        sys.stdout.flush()
+
+    def run(self):
+        self.reply({'status': 'ready', 'version': weasyprint.__version__})
+
+        for line in iter(sys.stdin.readline, ''):
+            line = line.strip()
+            if not line:
+                continue
+            jobId = None
+            try:
+                job = json.loads(line)
+                jobId = job.get('id')
+                self.convert(job)
+                self.reply({'id': jobId, 'status': 'ok'})
+            except Exception as err:
+                sys.stderr.write('weasyprintworker: job %s failed: %s\n' % (jobId, err))
+                sys.stderr.flush()
+                self.reply({'id': jobId, 'status': 'error', 'error': str(err)})
+
+
+if __name__ == "__main__":
+    Worker().run()